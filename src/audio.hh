@@ -0,0 +1,197 @@
+#ifndef AUDIO_HH_
+# define AUDIO_HH_
+
+# include <algorithm>
+# include <atomic>
+# include <cmath>
+# include <cstdint>
+# include <vector>
+
+namespace chip8
+{
+    /// @class AudioRing
+    /// @brief Lock-free ring of samples between a single producer, the
+    /// emulation, and a single consumer, the audio thread. Neither side
+    /// ever waits: samples that do not fit are dropped
+    class AudioRing
+    {
+        public:
+            // capacity is rounded up to a power of two
+            explicit AudioRing(std::size_t capacity);
+
+            // Producer: append up to n samples, returning how many fit
+            std::size_t write(const std::int16_t* samples, std::size_t n);
+
+            // Consumer: take up to n samples, returning how many were read
+            std::size_t read(std::int16_t* samples, std::size_t n);
+            // Consumer: drop up to n samples, the oldest first
+            std::size_t skip(std::size_t n);
+            // Samples readable
+            std::size_t size() const;
+
+        private:
+            std::vector<std::int16_t>   samples_;
+            std::size_t                 mask_;
+            std::atomic<std::size_t>    head_; // Written by the producer
+            std::atomic<std::size_t>    tail_; // Written by the consumer
+    };
+
+
+    /// @class Audio
+    /// @brief Sound of a Chip8, rendered one timer tick at a time into an
+    /// AudioRing that a sink, e.g. AudioOutput, plays from its own thread.
+    ///
+    /// Each tick renders 1/60 s of emulated time, silent or not, so that
+    /// sound follows the emulated clock rather than the host's. While the
+    /// sound timer runs, the XO-CHIP pattern plays at its pitch, or a
+    /// 500 Hz buzzer when the game never loaded one. The consumer keeps at
+    /// most latency samples queued, dropping the oldest ones when the
+    /// emulation runs ahead of real time, e.g. at fast forward
+    class Audio
+    {
+        public:
+            static const unsigned   RATE = 48000; // Samples per second
+            static const unsigned   TICK = RATE / 60; // Samples per tick
+
+            explicit Audio(std::size_t latency = 2 * TICK);
+
+            // Emulation thread: render the tick of machine about to end,
+            // before its updateTimers()
+            template <typename Machine>
+            void tick(const Machine& machine);
+
+            // Audio thread: read up to n samples, returning how many were
+            // ready
+            std::size_t read(std::int16_t* samples, std::size_t n);
+
+        private:
+            static const std::int16_t   AMPLITUDE = 4096;
+            // Pattern samples per second at pitch 64
+            static const unsigned       PATTERN_RATE = 4000;
+
+            AudioRing                   ring_;
+            std::size_t                 latency_;
+            std::uint32_t               phase_; // In the pattern, 16.16
+            std::int16_t                tick_[TICK];
+    };
+
+
+    inline AudioRing::AudioRing(std::size_t capacity)
+        : mask_(0)
+        , head_(0)
+        , tail_(0)
+    {
+        std::size_t size = 1;
+
+        while (size < capacity)
+            size <<= 1;
+        samples_.resize(size);
+        mask_ = size - 1;
+    }
+
+
+    inline std::size_t AudioRing::write(const std::int16_t* samples,
+                                        std::size_t n)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+
+        n = std::min(n, samples_.size() - (head - tail));
+        for (std::size_t i = 0; i < n; ++i)
+            samples_[(head + i) & mask_] = samples[i];
+
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+
+    inline std::size_t AudioRing::read(std::int16_t* samples, std::size_t n)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_acquire);
+
+        n = std::min(n, head - tail);
+        for (std::size_t i = 0; i < n; ++i)
+            samples[i] = samples_[(tail + i) & mask_];
+
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+
+    inline std::size_t AudioRing::skip(std::size_t n)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_acquire);
+
+        n = std::min(n, head - tail);
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+
+    inline std::size_t AudioRing::size() const
+    {
+        return head_.load(std::memory_order_acquire)
+            - tail_.load(std::memory_order_acquire);
+    }
+
+
+    inline Audio::Audio(std::size_t latency)
+        : ring_(std::max<std::size_t>(latency, TICK) + TICK)
+        , latency_(std::max<std::size_t>(latency, TICK))
+        , phase_(0)
+    {
+    }
+
+
+    template <typename Machine>
+    void Audio::tick(const Machine& machine)
+    {
+        // Buzzer: a square wave, 4 samples up then 4 down
+        static const std::uint8_t buzzer[16] =
+        {
+            0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0,
+            0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0
+        };
+
+        if (machine.soundTimer() == 0)
+        {
+            std::fill(tick_, tick_ + TICK, 0);
+            phase_ = 0;
+        }
+        else
+        {
+            const auto&         pattern = machine.pattern();
+            bool                loaded = std::any_of(
+                    pattern.begin(), pattern.end(),
+                    [](std::uint8_t byte) { return byte != 0; });
+            const std::uint8_t* bits = loaded ? pattern.data() : buzzer;
+            double              rate = loaded
+                ? PATTERN_RATE * std::exp2((machine.pitch() - 64) / 48.0)
+                : PATTERN_RATE;
+            std::uint32_t       step = rate * 65536 / RATE;
+
+            for (unsigned i = 0; i < TICK; ++i, phase_ += step)
+            {
+                unsigned bit = (phase_ >> 16) & 127;
+                tick_[i] = (bits[bit / 8] >> (7 - bit % 8)) & 1
+                    ? AMPLITUDE : -AMPLITUDE;
+            }
+        }
+
+        ring_.write(tick_, TICK);
+    }
+
+
+    inline std::size_t Audio::read(std::int16_t* samples, std::size_t n)
+    {
+        std::size_t queued = ring_.size();
+
+        if (queued > latency_)
+            ring_.skip(queued - latency_);
+        return ring_.read(samples, n);
+    }
+}
+
+#endif /* !AUDIO_HH_ */
@@ -0,0 +1,216 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include "chip8.hh"
+#include "headless.hh"
+#include "rom.hh"
+#include "thread_pool.hh"
+
+namespace
+{
+    // One line of the manifest: "ROM INPUT CYCLES", INPUT being "-" for
+    // no scripted input
+    struct Job
+    {
+        std::string             rom;
+        std::string             input;
+        unsigned long           cycles;
+        chip8::SessionResult    result;
+        std::string             error; // Empty unless the job failed
+    };
+
+
+    int usage(const char* name)
+    {
+        std::cerr << "usage: " << name << " MANIFEST [options]\n"
+            "  --threads N           worker threads (default: one per core)\n"
+            "  --cycles-per-frame N  instructions per frame (default 10)\n"
+            "  --core NAME           switch, threaded or jit (default threaded)\n"
+            "  --quirks NAME         default, vip, chip48, schip or modern\n"
+            "  --seed N              seed of every random generator (default 0)\n"
+            "Each manifest line is \"ROM INPUT CYCLES\", INPUT being - for none\n";
+        return 1;
+    }
+
+
+    bool loadManifest(const char* path, std::vector<Job>& jobs)
+    {
+        std::ifstream   ifs(path);
+        std::string     line;
+
+        if (!ifs)
+            return false;
+
+        while (std::getline(ifs, line))
+        {
+            std::istringstream  iss(line);
+            Job                 job = Job();
+
+            if (line.empty() || line[0] == '#')
+                continue;
+            if (!(iss >> job.rom >> job.input >> job.cycles))
+                return false;
+            jobs.push_back(job);
+        }
+
+        return true;
+    }
+
+
+    template <typename Core, typename Quirks>
+    void runJob(Job& job, chip8::RomCache& roms, unsigned cyclesPerFrame,
+                std::uint64_t seed)
+    {
+        chip8::Chip8<unsigned char, unsigned short, Core, chip8::NoProfile,
+                     Quirks> chip8;
+        chip8::InputScript input;
+        chip8::RomCache::Image rom = roms.get(job.rom);
+
+        if (rom == nullptr)
+        {
+            job.error = "invalid ROM";
+            return;
+        }
+        if (job.input != "-" && !input.load(job.input.c_str()))
+        {
+            job.error = "invalid input script " + job.input;
+            return;
+        }
+
+        chip8.initialize(seed);
+        chip8.loadGame(rom->data.data(), rom->data.size());
+        job.result = chip8::runSession(chip8, input, job.cycles,
+                                       cyclesPerFrame);
+    }
+
+
+    template <typename Core, typename Quirks>
+    void runAll(std::vector<Job>& jobs, unsigned threads,
+                unsigned cyclesPerFrame, std::uint64_t seed)
+    {
+        chip8::ThreadPool pool(threads);
+        chip8::RomCache roms;
+
+        // Jobs of the same game share one image of it
+        for (auto& job : jobs)
+            pool.submit([&job, &roms, cyclesPerFrame, seed]
+                        {
+                            runJob<Core, Quirks>(job, roms, cyclesPerFrame,
+                                                 seed);
+                        });
+        pool.wait();
+    }
+
+
+    // Run every job with the Quirks policy named quirks. False if there
+    // is no such policy
+    template <typename Core>
+    bool runAll(std::vector<Job>& jobs, const char* quirks, unsigned threads,
+                unsigned cyclesPerFrame, std::uint64_t seed)
+    {
+        if (std::strcmp(quirks, "default") == 0)
+            runAll<Core, chip8::DefaultQuirks>(jobs, threads, cyclesPerFrame,
+                                               seed);
+        else if (std::strcmp(quirks, "vip") == 0)
+            runAll<Core, chip8::VipQuirks>(jobs, threads, cyclesPerFrame, seed);
+        else if (std::strcmp(quirks, "chip48") == 0)
+            runAll<Core, chip8::Chip48Quirks>(jobs, threads, cyclesPerFrame,
+                                              seed);
+        else if (std::strcmp(quirks, "schip") == 0)
+            runAll<Core, chip8::SChipQuirks>(jobs, threads, cyclesPerFrame,
+                                             seed);
+        else if (std::strcmp(quirks, "modern") == 0)
+            runAll<Core, chip8::ModernQuirks>(jobs, threads, cyclesPerFrame,
+                                              seed);
+        else
+            return false;
+        return true;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char*     manifest = nullptr;
+    const char*     core = "threaded";
+    const char*     quirks = "default";
+    unsigned        threads = 0;
+    unsigned        cyclesPerFrame = 10;
+    std::uint64_t   seed = 0;
+    std::vector<Job> jobs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+            threads = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--cycles-per-frame") == 0 && hasValue)
+            cyclesPerFrame = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--core") == 0 && hasValue)
+            core = argv[++i];
+        else if (std::strcmp(argv[i], "--quirks") == 0 && hasValue)
+            quirks = argv[++i];
+        else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (argv[i][0] != '-' && manifest == nullptr)
+            manifest = argv[i];
+        else
+            return usage(argv[0]);
+    }
+
+    if (manifest == nullptr || cyclesPerFrame == 0)
+        return usage(argv[0]);
+    if (!loadManifest(manifest, jobs))
+    {
+        std::cerr << "Invalid manifest: " << manifest << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    bool known = false;
+
+    if (std::strcmp(core, "switch") == 0)
+        known = runAll<chip8::SwitchCore>(jobs, quirks, threads,
+                                          cyclesPerFrame, seed);
+    else if (std::strcmp(core, "threaded") == 0)
+        known = runAll<chip8::ThreadedCore>(jobs, quirks, threads,
+                                            cyclesPerFrame, seed);
+    else if (std::strcmp(core, "jit") == 0)
+        known = runAll<chip8::JitCore>(jobs, quirks, threads,
+                                       cyclesPerFrame, seed);
+    if (!known)
+        return usage(argv[0]);
+
+    double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    unsigned long cycles = 0;
+    int status = 0;
+
+    // Results in manifest order
+    for (const auto& job : jobs)
+    {
+        if (!job.error.empty())
+        {
+            std::cout << job.rom << " error: " << job.error << '\n';
+            status = 1;
+            continue;
+        }
+
+        std::cout << job.rom << std::hex << std::setfill('0')
+            << " screen=" << std::setw(16) << job.result.screenHash
+            << " state=" << std::setw(16) << job.result.stateHash
+            << std::dec
+            << " frames=" << job.result.frames
+            << " cycles=" << job.result.cycles
+            << " seconds=" << job.result.seconds << '\n';
+        cycles += job.result.cycles;
+    }
+
+    std::cerr << jobs.size() << " jobs, " << cycles << " cycles in "
+        << seconds << " s (" << cycles / seconds / 1e6 << " MIPS)"
+        << std::endl;
+    return status;
+}
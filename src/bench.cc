@@ -0,0 +1,414 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "chip8.hh"
+#include "wide.hh"
+
+namespace
+{
+    /// @struct Rom
+    /// @brief Synthetic ROM stressing one class of instructions, looping
+    /// forever
+    struct Rom
+    {
+        const char*                 name;
+        std::vector<unsigned char>  data;
+    };
+
+
+    struct Result
+    {
+        std::string     core;
+        std::string     rom;
+        unsigned long   cycles;
+        double          seconds;
+    };
+
+
+    int usage(const char* name)
+    {
+        std::cerr << "usage: " << name << " [options]\n"
+            "  --cycles N       instructions per run (default 20000000)\n"
+            "  --repeat N       runs of each ROM, the fastest counts (default 3)\n"
+            "  --core NAME      switch, threaded, jit or wide (default: all of them)\n"
+            "  --baseline FILE  compare with the output of a previous run\n"
+            "  --check N        random ROMs every core must agree on under each\n"
+            "                   quirks profile before measuring (default 20)\n"
+            "Prints one tab separated line per core and ROM\n";
+        return 1;
+    }
+
+
+    void emit(std::vector<unsigned char>& rom, unsigned short opcode)
+    {
+        rom.push_back(opcode >> 8);
+        rom.push_back(opcode & 0xFF);
+    }
+
+
+    // 8XY* and 7XNN in a loop
+    Rom aluRom()
+    {
+        Rom rom = { "alu", {} };
+        static const unsigned short loop[] = {
+            0x8014, 0x8125, 0x8231, 0x8302, 0x8413, 0x8016, 0x810E, 0x8247,
+            0x8340, 0x7001, 0x71FF, 0x8524, 0x8655, 0x8761, 0x8872, 0x8983,
+        };
+
+        emit(rom.data, 0x6001);
+        emit(rom.data, 0x6102);
+        emit(rom.data, 0x6203);
+        emit(rom.data, 0x6304);
+        for (auto opcode : loop)
+            emit(rom.data, opcode);
+        emit(rom.data, 0x1208);
+        return rom;
+    }
+
+
+    // Font sprites drawn 15 rows high, moving across the screen
+    Rom drawRom()
+    {
+        Rom rom = { "draw", {} };
+
+        emit(rom.data, 0x6000);
+        emit(rom.data, 0x6100);
+        emit(rom.data, 0xF229); // 0x204
+        emit(rom.data, 0xD01F);
+        emit(rom.data, 0x7005);
+        emit(rom.data, 0x7103);
+        emit(rom.data, 0x7201);
+        emit(rom.data, 0x1204);
+        return rom;
+    }
+
+
+    // Calls nested 12 deep, each function calling the next one
+    Rom callRom()
+    {
+        static const unsigned depth = 12;
+        Rom rom = { "call", {} };
+
+        emit(rom.data, 0x2210);
+        emit(rom.data, 0x1200);
+        for (unsigned level = 0; level < depth; ++level)
+        {
+            rom.data.resize(0x10 * (level + 1));
+            if (level + 1 < depth)
+                emit(rom.data, 0x2000 | (0x210 + 0x10 * (level + 1)));
+            emit(rom.data, 0x00EE);
+        }
+        return rom;
+    }
+
+
+    // Every register stored to and filled back from memory
+    Rom memoryRom()
+    {
+        Rom rom = { "memory", {} };
+
+        emit(rom.data, 0xA300);
+        emit(rom.data, 0xFF55);
+        emit(rom.data, 0xA300);
+        emit(rom.data, 0xFF65);
+        emit(rom.data, 0x7001);
+        emit(rom.data, 0x1200);
+        return rom;
+    }
+
+
+    // Random instructions, odd seeds looping back to 0x200 so that cached
+    // and compiled code gets run again, and possibly rewritten
+    Rom randomRom(std::uint64_t seed)
+    {
+        Rom             rom = { "random", {} };
+        chip8::Random   random(seed);
+        std::size_t     size = seed & 1 ? 0x300 : 0xE00;
+
+        while (rom.data.size() < size)
+            emit(rom.data, random.next() >> 16);
+        if (seed & 1)
+            emit(rom.data, 0x1200);
+        return rom;
+    }
+
+
+    // Whether the switch, threaded and jit cores and a Wide lane end every
+    // frame of rom with the same digest, printing where they first differ
+    template <typename Quirks>
+    bool coresAgree(const char* quirks, const Rom& rom, std::uint64_t seed)
+    {
+        typedef chip8::Chip8<unsigned char, unsigned short, chip8::SwitchCore,
+                             chip8::NoProfile, Quirks> Switch;
+        typedef chip8::Chip8<unsigned char, unsigned short,
+                             chip8::ThreadedCore, chip8::NoProfile,
+                             Quirks> Threaded;
+        typedef chip8::Chip8<unsigned char, unsigned short, chip8::JitCore,
+                             chip8::NoProfile, Quirks> Jit;
+        static const unsigned frames = 300;
+        static const unsigned long frame = 11;
+        std::unique_ptr<Switch>     switchCore(new Switch());
+        std::unique_ptr<Threaded>   threaded(new Threaded());
+        std::unique_ptr<Jit>        jit(new Jit());
+        std::unique_ptr<chip8::Wide<1, Quirks>> wide(
+                new chip8::Wide<1, Quirks>());
+
+        switchCore->initialize(seed);
+        threaded->initialize(seed);
+        jit->initialize(seed);
+        wide->initialize(seed);
+        switchCore->loadGame(rom.data.data(), rom.data.size());
+        threaded->loadGame(rom.data.data(), rom.data.size());
+        jit->loadGame(rom.data.data(), rom.data.size());
+        wide->loadGame(rom.data.data(), rom.data.size());
+
+        for (unsigned i = 0; i < frames; ++i)
+        {
+            switchCore->run(frame);
+            threaded->run(frame);
+            jit->run(frame);
+            wide->run(frame);
+            switchCore->updateTimers();
+            threaded->updateTimers();
+            jit->updateTimers();
+            wide->updateTimers();
+
+            std::uint64_t digest = switchCore->digest();
+
+            if (threaded->digest() != digest || jit->digest() != digest
+                || wide->digest(0) != digest)
+            {
+                std::cerr << "Cores disagree on " << rom.name << " ROM "
+                    << seed << " with " << quirks << " quirks at frame "
+                    << i << ", pc " << std::hex << switchCore->pc()
+                    << ": switch " << digest
+                    << " threaded " << threaded->digest()
+                    << " jit " << jit->digest()
+                    << " wide " << wide->digest(0) << std::dec << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    // Random ROMs 1 to count under Quirks, false if any core disagrees
+    template <typename Quirks>
+    bool checkCores(const char* quirks, unsigned count)
+    {
+        bool agree = true;
+
+        for (unsigned seed = 1; seed <= count; ++seed)
+            agree &= coresAgree<Quirks>(quirks, randomRom(seed), seed);
+        return agree;
+    }
+
+
+    template <typename Core>
+    double measure(const Rom& rom, unsigned long cycles, unsigned repeat)
+    {
+        typedef chip8::Chip8<unsigned char, unsigned short, Core> Machine;
+        static const unsigned long frame = 10000;
+        double best = 0;
+
+        for (unsigned i = 0; i < repeat; ++i)
+        {
+            std::unique_ptr<Machine> chip8(new Machine());
+
+            chip8->initialize();
+            chip8->loadGame(rom.data.data(), rom.data.size());
+
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned long done = 0; done < cycles; done += frame)
+            {
+                chip8->run(std::min(frame, cycles - done));
+                chip8->updateTimers();
+            }
+            double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+
+            if (i == 0 || seconds < best)
+                best = seconds;
+        }
+
+        return best;
+    }
+
+
+    // Same, with the instructions spread over the lanes of a Wide
+    template <unsigned Lanes>
+    double measureWide(const Rom& rom, unsigned long cycles, unsigned repeat)
+    {
+        static const unsigned long frame = 10000;
+        double best = 0;
+
+        cycles /= Lanes;
+        for (unsigned i = 0; i < repeat; ++i)
+        {
+            std::unique_ptr<chip8::Wide<Lanes>> wide(new chip8::Wide<Lanes>());
+
+            wide->initialize();
+            wide->loadGame(rom.data.data(), rom.data.size());
+
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned long done = 0; done < cycles; done += frame)
+            {
+                wide->run(std::min(frame, cycles - done));
+                wide->updateTimers();
+            }
+            double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+
+            if (i == 0 || seconds < best)
+                best = seconds;
+        }
+
+        return best;
+    }
+
+
+    template <typename Core>
+    void runAll(const char* core, const std::vector<Rom>& roms,
+                unsigned long cycles, unsigned repeat,
+                std::vector<Result>& results)
+    {
+        for (const auto& rom : roms)
+        {
+            Result result = { core, rom.name, cycles,
+                              measure<Core>(rom, cycles, repeat) };
+            results.push_back(result);
+        }
+    }
+
+
+    // MIPS by "CORE\tROM" from the output of a previous run
+    bool loadBaseline(const char* path, std::map<std::string, double>& mips)
+    {
+        std::ifstream   ifs(path);
+        std::string     line;
+
+        if (!ifs)
+            return false;
+
+        while (std::getline(ifs, line))
+        {
+            std::istringstream  iss(line);
+            std::string         core;
+            std::string         rom;
+            unsigned long       cycles;
+            double              seconds;
+            double              value;
+
+            if (line.empty() || line[0] == '#')
+                continue;
+            if (iss >> core >> rom >> cycles >> seconds >> value)
+                mips[core + '\t' + rom] = value;
+        }
+
+        return true;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char*     core = nullptr;
+    const char*     baseline = nullptr;
+    unsigned long   cycles = 20000000;
+    unsigned        repeat = 3;
+    unsigned        check = 20;
+    std::map<std::string, double> baselineMips;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--cycles") == 0 && hasValue)
+            cycles = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--repeat") == 0 && hasValue)
+            repeat = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--core") == 0 && hasValue)
+            core = argv[++i];
+        else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue)
+            baseline = argv[++i];
+        else if (std::strcmp(argv[i], "--check") == 0 && hasValue)
+            check = std::strtoul(argv[++i], nullptr, 0);
+        else
+            return usage(argv[0]);
+    }
+
+    if (cycles == 0 || repeat == 0)
+        return usage(argv[0]);
+    if (baseline != nullptr && !loadBaseline(baseline, baselineMips))
+    {
+        std::cerr << "Invalid baseline: " << baseline << std::endl;
+        return 1;
+    }
+
+    // Speed only counts if every core still computes the same thing
+    bool agree = checkCores<chip8::DefaultQuirks>("default", check);
+    agree &= checkCores<chip8::VipQuirks>("vip", check);
+    agree &= checkCores<chip8::Chip48Quirks>("chip48", check);
+    agree &= checkCores<chip8::SChipQuirks>("schip", check);
+    agree &= checkCores<chip8::ModernQuirks>("modern", check);
+    if (!agree)
+        return 1;
+
+    std::vector<Rom> roms = { aluRom(), drawRom(), callRom(), memoryRom() };
+    std::vector<Result> results;
+
+    if (core == nullptr || std::strcmp(core, "switch") == 0)
+        runAll<chip8::SwitchCore>("switch", roms, cycles, repeat, results);
+    if (core == nullptr || std::strcmp(core, "threaded") == 0)
+        runAll<chip8::ThreadedCore>("threaded", roms, cycles, repeat, results);
+    if (core == nullptr || std::strcmp(core, "jit") == 0)
+        runAll<chip8::JitCore>("jit", roms, cycles, repeat, results);
+    if (core == nullptr || std::strcmp(core, "wide") == 0)
+        for (const auto& rom : roms)
+        {
+            Result result = { "wide", rom.name, cycles / 32 * 32,
+                              measureWide<32>(rom, cycles, repeat) };
+            results.push_back(result);
+        }
+    if (results.empty())
+        return usage(argv[0]);
+
+    std::cout << "# core\trom\tinstructions\tseconds\tmips\tns_per_instruction";
+    if (baseline != nullptr)
+        std::cout << "\tbaseline_mips\tchange_percent";
+    std::cout << '\n' << std::fixed;
+
+    for (const auto& result : results)
+    {
+        double mips = result.cycles / result.seconds / 1e6;
+
+        std::cout << result.core << '\t' << result.rom << '\t'
+            << result.cycles << '\t'
+            << std::setprecision(6) << result.seconds << '\t'
+            << std::setprecision(2) << mips << '\t'
+            << std::setprecision(3) << result.seconds * 1e9 / result.cycles;
+
+        if (baseline != nullptr)
+        {
+            auto it = baselineMips.find(result.core + '\t' + result.rom);
+
+            if (it != baselineMips.end())
+                std::cout << '\t' << std::setprecision(2) << it->second
+                    << '\t' << std::showpos << (mips / it->second - 1) * 100
+                    << std::noshowpos;
+            else
+                std::cout << "\t-\t-";
+        }
+        std::cout << '\n';
+    }
+
+    return 0;
+}
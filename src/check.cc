@@ -0,0 +1,132 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "chip8.hh"
+#include "movie.hh"
+#include "wide.hh"
+
+namespace
+{
+    /// @struct Check
+    /// @brief Named check of a behaviour that has to hold, true when it does
+    struct Check
+    {
+        const char* name;
+        bool        (*run)(const std::string& dir);
+    };
+
+
+    bool writeFile(const std::string& path,
+                   const std::vector<unsigned char>& data)
+    {
+        std::ofstream ofs(path, std::ofstream::out | std::ofstream::binary);
+
+        ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+        return ofs.good();
+    }
+
+
+    // Movie header for seed 0
+    std::vector<unsigned char> movieHeader()
+    {
+        std::vector<unsigned char> data(sizeof (chip8::MOVIE_MAGIC)
+                                        + sizeof (chip8::MOVIE_VERSION)
+                                        + sizeof (std::uint64_t), 0);
+
+        std::memcpy(data.data(), chip8::MOVIE_MAGIC,
+                    sizeof (chip8::MOVIE_MAGIC));
+        std::memcpy(data.data() + sizeof (chip8::MOVIE_MAGIC),
+                    &chip8::MOVIE_VERSION, sizeof (chip8::MOVIE_VERSION));
+        return data;
+    }
+
+
+    // The largest delta, 10 varint bytes, comes back whole
+    bool movieLongestDelta(const std::string& dir)
+    {
+        std::string     path = dir + "/check-longest.c8mv";
+        chip8::Movie    saved;
+        chip8::Movie    loaded;
+
+        saved.record(~std::uint64_t(0), chip8::Movie::TICK);
+        bool ok = saved.save(path.c_str()) && loaded.load(path.c_str())
+            && loaded.events().size() == 1
+            && loaded.events()[0].cycle == ~std::uint64_t(0)
+            && loaded.events()[0].code == chip8::Movie::TICK;
+        std::remove(path.c_str());
+        return ok;
+    }
+
+
+    // Deltas of 11 varint bytes or more do not fit in 64 bits and are
+    // rejected
+    bool movieOverlongDelta(const std::string& dir)
+    {
+        std::string path = dir + "/check-overlong.c8mv";
+        bool        ok = true;
+
+        for (unsigned continued = 10; continued <= 16 && ok; continued += 6)
+        {
+            std::vector<unsigned char>  data = movieHeader();
+            chip8::Movie                movie;
+
+            data.insert(data.end(), continued, 0xFF);
+            data.push_back(0x01);
+            data.push_back(std::uint8_t(chip8::Movie::TICK));
+            ok = writeFile(path, data) && !movie.load(path.c_str());
+        }
+
+        std::remove(path.c_str());
+        return ok;
+    }
+
+
+    // An empty ROM file maps to no data, and loads as an empty game
+    bool emptyRom(const std::string& dir)
+    {
+        typedef chip8::Chip8<unsigned char, unsigned short> Machine;
+        std::string                     path = dir + "/check-empty.ch8";
+        std::unique_ptr<Machine>        machine(new Machine());
+        std::unique_ptr<chip8::Wide<2>> wide(new chip8::Wide<2>());
+        chip8::MappedFile               file;
+
+        machine->initialize();
+        wide->initialize();
+        bool ok = writeFile(path, std::vector<unsigned char>())
+            && machine->loadGame(path.c_str()) && file.open(path.c_str())
+            && wide->loadGame(file.data(), file.size());
+        std::remove(path.c_str());
+        return ok;
+    }
+
+
+    const Check checks[] =
+    {
+        { "movie longest delta", movieLongestDelta },
+        { "movie overlong delta", movieOverlongDelta },
+        { "empty rom", emptyRom },
+    };
+}
+
+
+int main(int argc, char *argv[])
+{
+    // Scratch files go to the given directory
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+    unsigned    failed = 0;
+
+    for (const Check& check : checks)
+    {
+        bool ok = check.run(dir);
+
+        std::cout << (ok ? "ok\t" : "FAILED\t") << check.name << '\n';
+        failed += !ok;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
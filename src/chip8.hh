@@ -5,16 +5,47 @@
 # include <iostream>
 # include <stdlib.h>
 # include <stdio.h>
+# include <algorithm>
 # include <array>
-# include <SFML/Graphics.hpp>
+# include <bitset>
+# include <cstdint>
+# include <cstring>
+# include <type_traits>
+# include "input.hh"
+# include "jit.hh"
 # include "opcodes.hh"
+# include "profile.hh"
+# include "quirks.hh"
+# include "random.hh"
+# include "rom.hh"
+# include "screen.hh"
+# include "snapshot.hh"
 # include "utility.hh"
 
+# if defined(__GNUC__) && !defined(CHIP8_NO_COMPUTED_GOTO)
+#  define CHIP8_COMPUTED_GOTO
+# endif
+
 namespace chip8
 {
+    /// @brief Interpreter core selecting how Chip8::run() dispatches
+    /// instructions: through the central switch of decode(), one
+    /// instruction per call to step()
+    struct SwitchCore {};
+
+    /// @brief Interpreter core where each handler jumps straight to the
+    /// next one, using labels as values when the compiler supports them
+    /// and a table of member function pointers otherwise
+    struct ThreadedCore {};
+
     /// @class Chip8
-    /// @brief Class for Chip8 emulator
-    template <typename Byte, typename Word>
+    /// @brief Class for Chip8 emulator, whose Instrument policy (NoProfile,
+    /// Profile, Trace) sees every instruction executed, and whose Quirks
+    /// policy (DefaultQuirks, VipQuirks...) picks the behavior of the
+    /// instructions interpreters disagree on
+    template <typename Byte, typename Word, typename Core = SwitchCore,
+              typename Instrument = NoProfile,
+              typename Quirks = DefaultQuirks>
     class Chip8
     {
         public:
@@ -22,33 +53,131 @@ namespace chip8
             ~Chip8() = default;
 
             // Methods
-            void initialize();
-            void loadGame(const char* rom);
+            void initialize(std::uint64_t seed = 0);
+            // Load a game at 0x200. False, loading nothing, if it cannot
+            // be read or is larger than the ROM_CAPACITY bytes available
+            bool loadGame(const char* rom);
+            bool loadGame(const unsigned char* data, std::size_t size);
             void cycle();
+            // Execute n instructions with the selected Core, idle loops
+            // being fast forwarded unless instrumented
+            void run(unsigned long n);
             void updateTimers();
 
-            void setDrawFlag(bool val) { drawFlag_ = val; }
-            bool getDrawFlag() const { return drawFlag_; }
+            // Rows (bit y for row y) that differ from the screen as it was
+            // last presented, every row after a change of resolution
+            std::uint64_t dirtyRows() const;
+            // The screen has been presented as it is now
+            void markPresented();
+
+            // Press or release a key, from 0x0 to 0xF, which stays held in
+            // between
+            void pressKey(unsigned key);
+            void releaseKey(unsigned key);
+
+            // Machine state, for frontends
+            const Screen& screen() const { return screen_; }
+            const std::array<Byte, MEMORY_SIZE>& memory() const
+            {
+                return memory_;
+            }
+            const std::array<Byte, 16>& registers() const { return registers_; }
+            Word index() const { return I_; }
+            Word pc() const { return pc_; }
+            Byte delayTimer() const { return delay_timer_; }
+            Byte soundTimer() const { return sound_timer_; }
+            // SUPER-CHIP RPL user flags
+            const std::array<Byte, 16>& flags() const { return flags_; }
+            // XO-CHIP audio: 128 one bit samples, played at
+            // 4000 * 2 ^ ((pitch - 64) / 48) Hz while the sound timer runs
+            const std::array<Byte, 16>& pattern() const { return pattern_; }
+            Byte pitch() const { return pitch_; }
+            // Instructions executed since initialize()
+            std::uint64_t cycles() const { return cycles_; }
+            // Seed given to initialize(), for RAND
+            std::uint64_t seed() const { return seed_; }
+            // Hash of the whole machine state
+            std::uint64_t digest() const;
+            // Instrument policy, e.g. for its counts
+            Instrument& instrument() { return instrument_; }
+            const Instrument& instrument() const { return instrument_; }
 
-            // Update key pressed
-            void setKey();
-            // Draw
-            void draw(sf::RenderWindow& window) const;
+            // Save the whole machine state into snapshot
+            void saveState(Snapshot& snapshot);
+            // Restore a state saved by saveState(), for instance from a
+            // MappedFile. Its memory is copied, the machine owning the
+            // memory its caches and compiled blocks are checked against.
+            // False if it is not valid
+            bool loadState(const unsigned char* data, std::size_t size);
+            // Same, only copying the memory pages written since when this
+            // machine last saved or loaded snapshot, e.g. to fork many runs
+            // from one checkpoint
+            bool loadState(const Snapshot& snapshot);
+            // Size of a saved state
+            static std::size_t stateSize();
 
         private:
+            typedef Instruction<Byte, Word> Instr;
+
+            // Fetch the pre-decoded instruction at pc_, or at address
+            const Instr& fetch() { return fetch(pc_); }
+            const Instr& fetch(Word address);
+            // Execute the instruction at pc_
+            void step();
+            typedef void (Chip8::*Handler)(const Instr&);
+
+            // Leading instructions of the n of run() that it can account
+            // for at once, an idle loop at pc_ repeating them until its
+            // end. Keys and timers only change between runs, so the
+            // machine is left as if they were executed
+            unsigned long fastForward(unsigned long n);
+            // Core specific implementations of run()
+            void run(unsigned long n, SwitchCore);
+            void run(unsigned long n, ThreadedCore);
+            void run(unsigned long n, JitCore);
+            // Execute instr as op, for handler tables
+            template <Opcode op>
+            void handle(const Instr& instr) { decode(op, instr); }
 
             // Decode and execute one opcode
-            void decode(Word opcode);
+            void decode(Opcode op, const Instr& instr);
             // Draw a sprite
-            void drawSprite(Word opcode);
+            void drawSprite(const Instr& instr);
+            // Skip the instruction at pc_, F000 NNNN being twice as long
+            void skip();
+            // Write to memory, dropping stale pre-decoded instructions
+            void store(Word address, Byte value);
+            // Forget every pre-decoded instruction
+            void flushCache();
+            // loadState(), copying all of memory or, when this machine
+            // last saved or loaded these very data, the dirty pages only
+            bool restore(const unsigned char* data, std::size_t size,
+                         bool dirtyOnly);
+
+# ifdef CHIP8_JIT
+            friend class Jit<Chip8, Quirks>;
+            typedef typename std::conditional<
+                std::is_same<Core, JitCore>::value,
+                Jit<Chip8, Quirks>,
+                NoJit>::type            JitCache;
+# else
+            typedef NoJit               JitCache;
+# endif
 
             // Chip8 internal
-            std::array<Byte, 4096>      memory_; // Memory
+            std::array<Byte, MEMORY_SIZE> memory_; // Memory
+            std::array<Instr, 4096>     cache_; // Pre-decoded instructions
             std::array<Byte, 16>        registers_; // registers
             Word                        I_; // Index register
-            Word                        pc_; // program counter
-            std::array<bool, 64 * 32>   screen_; // Screen
-            bool                        drawFlag_;
+            Word                        pc_; // program counter, below 0x1000
+            std::uint64_t               cycles_; // Instructions executed
+            Screen                      screen_;
+            Screen::Rows                presented_; // Screen last presented
+            bool                        presentedHires_;
+            std::uint64_t               dirty_; // Rows touched since then
+            std::array<Byte, 16>        flags_; // RPL user flags
+            std::array<Byte, 16>        pattern_; // Audio samples
+            Byte                        pitch_;
 
             // Timers
             Byte                        delay_timer_;
@@ -56,15 +185,33 @@ namespace chip8
 
             // Stack
             std::array<Word, 16>        stack_;
-            Word                        sp_;
+            Word                        sp_; // Wraps within the 16 entries
 
             // Gamepad
-            std::array<bool, 16>        key_;
+            std::array<bool, 16>        key_; // Held
+            Byte                        await_; // FX0A progress
+
+            // Random numbers
+            std::uint64_t               seed_;
+            Random                      random_;
+
+            // Snapshots
+            static const unsigned       PAGE = 256;
+            // Written since last save or load
+            std::bitset<MEMORY_SIZE / PAGE> dirtyPages_;
+            std::uint64_t               epoch_; // Last saved or loaded, 0 if none
+
+            // Compiled blocks, for JitCore
+            JitCache                    jit_;
+
+            Instrument                  instrument_;
     };
 
 
-    template <typename Byte, typename Word>
-    void Chip8<Byte, Word>::initialize()
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::initialize(
+            std::uint64_t seed)
     {
         debug("Initializing chip8 emulator");
 
@@ -72,16 +219,19 @@ namespace chip8
         static_assert(sizeof(Byte) == 1, "sizeof (Byte) != 1");
         static_assert(sizeof(Word) == 2, "sizeof (Word) != 2");
 
-        debug("Init random generator");
-        srand(time(NULL));
-
         debug("Init internals");
         memory_.fill(0);
         registers_.fill(0);
-        screen_.fill(false);
+        screen_ = Screen();
         I_  = 0;
         pc_ = 0x200;
-        drawFlag_ = false;
+        cycles_ = 0;
+        presented_.fill(Screen::Row());
+        presentedHires_ = false;
+        dirty_ = 0;
+        flags_.fill(0);
+        pattern_.fill(0);
+        pitch_ = 64;
 
         delay_timer_ = 0;
         sound_timer_ = 0;
@@ -90,230 +240,804 @@ namespace chip8
         sp_ = 0;
 
         key_.fill(false);
+        await_ = AWAIT_IDLE;
+
+        debug("Init random generator");
+        seed_ = seed;
+        random_.reseed(seed);
 
         // Load fontset
         debug("Init fontset");
         for(int i = 0; i < 80; ++i)
             memory_[i] = chip8_fontset[i];
+        for (unsigned i = 0; i < sizeof (chip8_bigfontset); ++i)
+            memory_[BIG_FONT_ADDRESS + i] = chip8_bigfontset[i];
+
+        flushCache();
+        dirtyPages_.set();
+        epoch_ = 0;
     }
 
 
-    template <typename Byte, typename Word>
-    void Chip8<Byte, Word>::loadGame(const char* rom)
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    bool Chip8<Byte, Word, Core, Instrument, Quirks>::loadGame(const char* rom)
     {
-        std::ifstream ifs;
-
-        ifs.open(rom, std::ifstream::in | std::ifstream::binary);
+        MappedFile file;
 
         debug("Loading game: ", rom);
 
-        for (unsigned i = 0; ifs.good(); ++i)
+        return file.open(rom) && loadGame(file.data(), file.size());
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    bool Chip8<Byte, Word, Core, Instrument, Quirks>::loadGame(
+            const unsigned char* data, std::size_t size)
+    {
+        if (size > ROM_CAPACITY)
+            return false;
+
+        // An empty ROM, e.g. mapped from an empty file, may have no data
+        if (size > 0)
+            std::memcpy(&memory_[ROM_ADDRESS], data, size);
+
+        flushCache();
+        dirtyPages_.set();
+        return true;
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::pressKey(unsigned key)
+    {
+        if (key < 16)
         {
-            memory_[pc_ + i] = ifs.get();
+            key_[key] = true;
+            await_ = awaitPress(await_, key);
         }
-        ifs.close();
     }
 
 
-    template <typename Byte, typename Word>
-    void Chip8<Byte, Word>::setKey()
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::releaseKey(unsigned key)
     {
-        key_[getKey()] = true;
+        if (key < 16)
+        {
+            key_[key] = false;
+            await_ = awaitRelease(await_, key);
+        }
     }
 
 
-    template <typename Byte, typename Word>
-    void Chip8<Byte, Word>::draw(sf::RenderWindow& window) const
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    std::uint64_t Chip8<Byte, Word, Core, Instrument, Quirks>::dirtyRows() const
     {
-        for (unsigned y = 0; y < 32; ++y)
+        std::uint64_t rows = 0;
+
+        if (screen_.hires() != presentedHires_)
+            return ~std::uint64_t(0) >> (Screen::HEIGHT - screen_.height());
+
+        // Rows drawn back to what was presented, e.g. a sprite erased by
+        // drawing it again, are not dirty
+        for (std::uint64_t touched = dirty_; touched != 0; touched &= touched - 1)
         {
-            for (unsigned x = 0; x < 64; ++x)
-            {
-                if (screen_[(y * 64) + x])
-                {
-                    sf::RectangleShape sprite(sf::Vector2f(1, 1));
-                    sprite.setPosition(x, y);
-                    sprite.setFillColor(sf::Color::White);
-                    window.draw(sprite);
-                }
-            }
+            unsigned y = lowestBit(touched);
+            if (screen_[y] != presented_[y])
+                rows |= std::uint64_t(1) << y;
+        }
+
+        return rows;
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::markPresented()
+    {
+        for (std::uint64_t touched = dirty_; touched != 0; touched &= touched - 1)
+        {
+            unsigned y = lowestBit(touched);
+            presented_[y] = screen_[y];
         }
+        presentedHires_ = screen_.hires();
+        dirty_ = 0;
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    std::uint64_t Chip8<Byte, Word, Core, Instrument, Quirks>::digest() const
+    {
+        std::uint64_t hash = fnv1a(memory_.data(), memory_.size());
+
+        hash = fnv1a(registers_.data(), registers_.size(), hash);
+        hash = fnv1a(&I_, sizeof (I_), hash);
+        hash = fnv1a(&pc_, sizeof (pc_), hash);
+        hash = fnv1a(screen_.rows().data(), sizeof (screen_.rows()), hash);
+        std::uint8_t hires = screen_.hires();
+        hash = fnv1a(&hires, sizeof (hires), hash);
+        std::uint8_t planes = screen_.planes();
+        hash = fnv1a(&planes, sizeof (planes), hash);
+        hash = fnv1a(flags_.data(), flags_.size(), hash);
+        hash = fnv1a(pattern_.data(), pattern_.size(), hash);
+        hash = fnv1a(&pitch_, sizeof (pitch_), hash);
+        hash = fnv1a(&delay_timer_, sizeof (delay_timer_), hash);
+        hash = fnv1a(&sound_timer_, sizeof (sound_timer_), hash);
+        hash = fnv1a(stack_.data(), sizeof (stack_), hash);
+        hash = fnv1a(&sp_, sizeof (sp_), hash);
+        hash = fnv1a(&await_, sizeof (await_), hash);
+
+        std::uint64_t random = random_.state();
+        hash = fnv1a(&random, sizeof (random), hash);
+        return hash;
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::drawSprite(
+            const Instr& instr)
+    {
+        // DXY0 draws a 16x16 sprite at high resolution
+        bool    wide = (instr.nn & 0x000F) == 0 && screen_.hires();
+        bool    collision;
+
+        dirty_ |= screen_.draw<Quirks::clipsSprites>(
+                memory_.data(), I_, registers_[instr.x], registers_[instr.y],
+                wide ? 16 : instr.nn & 0x000F, wide, collision);
+        registers_[15] = collision;
     }
 
 
-    template <typename Byte, typename Word>
-    void Chip8<Byte, Word>::drawSprite(Word opcode)
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    std::size_t Chip8<Byte, Word, Core, Instrument, Quirks>::stateSize()
     {
-        Word x = registers_[get<1>(opcode)];
-        Word y = registers_[get<2>(opcode)];
-        Word height = opcode & 0x000F;
-        Word pixel;
-        bool value;
-
-        registers_[15] = 0;
-        for (int yline = 0; yline < height; ++yline)
+        return sizeof (STATE_MAGIC) + sizeof (std::uint32_t) * 2
+            + sizeof (memory_) + sizeof (registers_) + sizeof (I_)
+            + sizeof (pc_) + sizeof (cycles_) + sizeof (stack_) + sizeof (sp_)
+            + sizeof (delay_timer_) + sizeof (sound_timer_) + sizeof (key_)
+            + sizeof (await_)
+            + sizeof (Screen::Rows) + sizeof (std::uint8_t) * 2
+            + sizeof (flags_) + sizeof (pattern_) + sizeof (pitch_)
+            + sizeof (seed_) + sizeof (std::uint64_t);
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::saveState(
+            Snapshot& snapshot)
+    {
+        std::uint32_t size = stateSize();
+
+        // Memory pages are only copied when written since the last save
+        // into this very snapshot
+        if (epoch_ == 0 || snapshot.epoch != epoch_
+            || snapshot.data.size() != size)
         {
-            pixel = memory_[I_ + yline];
-            for (int xline = 0; xline < 8; ++xline)
+            snapshot.data.resize(size);
+            dirtyPages_.set();
+        }
+
+        StateWriter out(snapshot.data.data());
+        out.put(STATE_MAGIC);
+        out.put(STATE_VERSION);
+        out.put(size);
+
+        unsigned char* memory = out.skip(sizeof (memory_));
+        std::uint32_t  start = memory - snapshot.data.data();
+        snapshot.written.clear();
+        snapshot.wrote(0, start);
+        for (unsigned page = 0; page < memory_.size() / PAGE; ++page)
+            if (dirtyPages_[page])
             {
-                value = (pixel & (0x80 >> xline)) != 0;
-                if (screen_[(x + xline + ((y + yline) * 64))] && !value)
-                    registers_[15] = 1;
-                screen_[x + xline + ((y + yline) * 64)] ^= value;
+                std::memcpy(memory + page * PAGE, &memory_[page * PAGE], PAGE);
+                snapshot.wrote(start + page * PAGE, start + (page + 1) * PAGE);
             }
+        snapshot.wrote(start + sizeof (memory_), size);
+
+        out.put(registers_);
+        out.put(I_);
+        out.put(pc_);
+        out.put(cycles_);
+        out.put(stack_);
+        out.put(sp_);
+        out.put(delay_timer_);
+        out.put(sound_timer_);
+        out.put(key_);
+        out.put(await_);
+        out.put(screen_.rows());
+        out.put(std::uint8_t(screen_.hires()));
+        out.put(std::uint8_t(screen_.planes()));
+        out.put(flags_);
+        out.put(pattern_);
+        out.put(pitch_);
+        out.put(seed_);
+        out.put(random_.state());
+
+        dirtyPages_.reset();
+        snapshot.epoch = epoch_ = nextEpoch();
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    bool Chip8<Byte, Word, Core, Instrument, Quirks>::loadState(
+            const unsigned char* data, std::size_t size)
+    {
+        if (!restore(data, size, false))
+            return false;
+
+        dirtyPages_.set();
+        epoch_ = 0;
+        return true;
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    bool Chip8<Byte, Word, Core, Instrument, Quirks>::loadState(
+            const Snapshot& snapshot)
+    {
+        // As in saveState(), memory only differs from the snapshot in the
+        // pages written since, if the machine last saved or loaded it
+        bool same = epoch_ != 0 && snapshot.epoch == epoch_;
+
+        if (!restore(snapshot.data.data(), snapshot.data.size(), same))
+            return false;
+
+        dirtyPages_.reset();
+        epoch_ = snapshot.epoch;
+        return true;
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    bool Chip8<Byte, Word, Core, Instrument, Quirks>::restore(
+            const unsigned char* data, std::size_t size, bool dirtyOnly)
+    {
+        StateReader             in(data, size);
+        char                    magic[sizeof (STATE_MAGIC)];
+        std::uint32_t           version;
+        std::uint32_t           stateSize;
+        const unsigned char*    memory;
+        std::array<Byte, 16>    registers;
+        Word                    I;
+        Word                    pc;
+        std::uint64_t           cycles;
+        std::array<Word, 16>    stack;
+        Word                    sp;
+        Byte                    delayTimer;
+        Byte                    soundTimer;
+        std::array<std::uint8_t, sizeof (key_)> key;
+        Byte                    await;
+        Screen::Rows            rows;
+        std::uint8_t            hires;
+        std::uint8_t            planes;
+        std::array<Byte, 16>    flags;
+        std::array<Byte, 16>    pattern;
+        Byte                    pitch;
+        std::uint64_t           seed;
+        std::uint64_t           random;
+
+        if (!in.get(magic) || !in.get(version) || !in.get(stateSize)
+            || std::memcmp(magic, STATE_MAGIC, sizeof (magic)) != 0
+            || version != STATE_VERSION
+            || stateSize != Chip8::stateSize() || size < stateSize)
+            return false;
+
+        // Everything is read and checked before the machine changes, so
+        // that a corrupt state leaves it as it was
+        if ((memory = in.skip(sizeof (memory_))) == nullptr
+            || !in.get(registers) || !in.get(I) || !in.get(pc)
+            || !in.get(cycles) || !in.get(stack) || !in.get(sp)
+            || !in.get(delayTimer) || !in.get(soundTimer) || !in.get(key)
+            || !in.get(await) || !in.get(rows) || !in.get(hires)
+            || !in.get(planes) || !in.get(flags) || !in.get(pattern)
+            || !in.get(pitch) || !in.get(seed) || !in.get(random))
+            return false;
+
+        if (pc > 0x0FFF || sp >= stack.size() || !awaitValid(await)
+            || std::any_of(stack.begin(), stack.end(),
+                           [](Word entry) { return entry > 0x0FFF; })
+            || std::any_of(key.begin(), key.end(),
+                           [](std::uint8_t held) { return held > 1; }))
+            return false;
+
+        if (dirtyOnly)
+        {
+            // Through store(), only dropping the cached instructions and
+            // compiled blocks of the bytes that change
+            for (unsigned page = 0; page < memory_.size() / PAGE; ++page)
+                if (dirtyPages_[page])
+                    for (unsigned i = page * PAGE; i < (page + 1) * PAGE; ++i)
+                        if (memory_[i] != memory[i])
+                            store(i, memory[i]);
         }
+        else
+        {
+            std::memcpy(&memory_[0], memory, sizeof (memory_));
+            flushCache();
+        }
+        registers_ = registers;
+        I_ = I;
+        pc_ = pc;
+        cycles_ = cycles;
+        stack_ = stack;
+        sp_ = sp;
+        delay_timer_ = delayTimer;
+        sound_timer_ = soundTimer;
+        for (unsigned i = 0; i < key_.size(); ++i)
+            key_[i] = key[i] != 0;
+        await_ = await;
+        screen_.rows() = rows;
+        screen_.setHires(hires != 0);
+        screen_.setPlanes(planes);
+        flags_ = flags;
+        pattern_ = pattern;
+        pitch_ = pitch;
+        seed_ = seed;
+        random_.setState(random);
+
+        dirty_ = ~std::uint64_t(0);
+        return true;
     }
 
 
-    template <typename Byte, typename Word>
-    void Chip8<Byte, Word>::updateTimers()
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::updateTimers()
     {
         if (delay_timer_ > 0)
             --delay_timer_;
 
         if (sound_timer_ > 0)
-        {
-            if (sound_timer_ == 1)
-                std::cout << '\a';
             --sound_timer_;
-        }
     }
 
 
-    template <typename Byte, typename Word>
-    void Chip8<Byte, Word>::cycle()
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::cycle()
+    {
+        ++cycles_;
+        step();
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::step()
     {
         // Fetch opcode
-        Word opcode =
-            (memory_[pc_] << 8)
-            | memory_[pc_ + 1];
+        const Instr& instr = fetch();
 
         // Jump to next instruction
-        pc_ += 2;
+        pc_ = (pc_ + 2) & 0x0FFF;
+
+        // Execute opcode
+        decode(static_cast<Opcode>(instr.op), instr);
+    }
+
 
-        // Decode and execute opcode
-        decode(opcode);
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::run(unsigned long n)
+    {
+        cycles_ += n;
+        // Each instruction executed must reach instrument_
+        if (!Instrument::enabled)
+            n -= fastForward(n);
+        run(n, Core());
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    unsigned long Chip8<Byte, Word, Core, Instrument, Quirks>::fastForward(
+            unsigned long n)
+    {
+        if (pc_ >= cache_.size())
+            return 0;
+
+        const Instr& instr = fetch();
+
+        // 1NNN to itself, 00FD
+        if ((instr.op == JUMP && instr.nnn == pc_) || instr.op == EXIT)
+            return n;
+        // FX0A until a key is pressed and released
+        if (instr.op == KEY_AWAIT && await_ != AWAIT_IDLE
+            && !(await_ & AWAIT_RELEASED))
+            return n;
+
+        // FX07, 3XNN or 4XNN, 1NNN back to FX07: waiting for the delay
+        // timer to become, or stop being, NN. pc_ may be at any of them
+        for (Word offset = 0; offset < 6; offset += 2)
+        {
+            Word            head = pc_ - offset;
+            unsigned long   steps = (6 - offset) % 6 / 2; // To head
+
+            if (pc_ < offset || head >= cache_.size() - 4)
+                break;
+
+            const Instr& timer = fetch(head);
+            const Instr& test = fetch(head + 2);
+            const Instr& jump = fetch(head + 4);
+
+            if (timer.op != SET_XTIMER
+                || (test.op != SKIPS_EQ_XNN && test.op != SKIPS_NEQ_XNN)
+                || test.x != timer.x || jump.op != JUMP || jump.nnn != head)
+                continue;
+
+            // Reach the head, unless the loop ends on the way
+            if (steps >= n)
+                return 0;
+            for (unsigned long i = 0; i < steps; ++i)
+                step();
+            if (pc_ != head
+                || (test.op == SKIPS_EQ_XNN) == (delay_timer_ == test.nn))
+                return steps;
+
+            // Whole iterations only, each setting VX to the timer
+            unsigned long loops = (n - steps) / 3;
+            if (loops > 0)
+                registers_[timer.x] = delay_timer_;
+            return steps + loops * 3;
+        }
+
+        return 0;
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::run(
+            unsigned long n, SwitchCore)
+    {
+        while (n--)
+            step();
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::run(
+            unsigned long n, ThreadedCore)
+    {
+        // Handlers are listed in the order of the Opcode enum
+# ifdef CHIP8_COMPUTED_GOTO
+#  define CHIP8_LABEL(op) &&handle_##op,
+#  define CHIP8_HANDLER(op)                                             \
+        handle_##op:                                                    \
+            decode(op, *instr);                                         \
+            CHIP8_DISPATCH();
+#  define CHIP8_DISPATCH()                                              \
+        if (n-- == 0)                                                   \
+            return;                                                     \
+        instr = &fetch();                                               \
+        pc_ = (pc_ + 2) & 0x0FFF;                                       \
+        goto *labels[instr->op];
+
+        static void* const labels[] = { CHIP8_OPCODES(CHIP8_LABEL) };
+        static_assert(sizeof (labels) / sizeof (*labels) == UNKNOWN + 1,
+                      "labels must cover every Opcode");
+        const Instr* instr;
+
+        CHIP8_DISPATCH();
+        CHIP8_OPCODES(CHIP8_HANDLER)
+
+#  undef CHIP8_DISPATCH
+#  undef CHIP8_HANDLER
+#  undef CHIP8_LABEL
+# else
+#  define CHIP8_ENTRY(op) &Chip8::template handle<op>,
+
+        static const Handler handlers[] = { CHIP8_OPCODES(CHIP8_ENTRY) };
+        static_assert(sizeof (handlers) / sizeof (*handlers) == UNKNOWN + 1,
+                      "handlers must cover every Opcode");
+
+        while (n--)
+        {
+            const Instr& instr = fetch();
+            pc_ = (pc_ + 2) & 0x0FFF;
+            (this->*handlers[instr.op])(instr);
+        }
+
+#  undef CHIP8_ENTRY
+# endif
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::run(
+            unsigned long n, JitCore)
+    {
+# ifdef CHIP8_JIT
+        // Compiled blocks would hide their instructions from instrument_
+        if (Instrument::enabled)
+            return run(n, ThreadedCore());
+
+        while (n > 0)
+        {
+            auto& block = jit_.lookup(*this, pc_);
+
+            // Blocks only run whole, so that n is never overshot
+            if (block.length > 0 && block.length <= n)
+            {
+                block.code(this);
+                n -= block.length;
+            }
+            else
+            {
+                step();
+                --n;
+            }
+        }
+# else
+        run(n, ThreadedCore());
+# endif
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    const typename Chip8<Byte, Word, Core, Instrument, Quirks>::Instr&
+    Chip8<Byte, Word, Core, Instrument, Quirks>::fetch(Word address)
+    {
+        Word    pc = address & 0x0FFF;
+        Instr&  instr = cache_[pc];
+
+        // Decode lazily, the first time this address is executed
+        if (instr.op == Instr::UNDECODED)
+            instr = predecode<Byte, Word>(
+                    (memory_[pc] << 8) | memory_[(pc + 1) & 0x0FFF]);
+
+        return instr;
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::store(
+            Word address, Byte value)
+    {
+        memory_[address] = value;
+        dirtyPages_[address / PAGE] = true;
+
+        // Both instructions overlapping this byte are now stale, if it
+        // holds code at all
+        if (address < cache_.size())
+        {
+            cache_[address].op = Instr::UNDECODED;
+            cache_[(address - 1) & 0x0FFF].op = Instr::UNDECODED;
+            jit_.invalidate(address);
+        }
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::skip()
+    {
+        if (memory_[pc_] == 0xF0 && memory_[(pc_ + 1) & 0x0FFF] == 0x00)
+            pc_ = (pc_ + 4) & 0x0FFF;
+        else
+            pc_ = (pc_ + 2) & 0x0FFF;
     }
 
 
-    template <typename Byte, typename Word>
-    void Chip8<Byte, Word>::decode(Word opcode)
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    void Chip8<Byte, Word, Core, Instrument, Quirks>::flushCache()
+    {
+        for (auto& instr : cache_)
+            instr.op = Instr::UNDECODED;
+        jit_.flush();
+    }
+
+
+    template <typename Byte, typename Word, typename Core, typename Instrument,
+              typename Quirks>
+    CHIP8_INLINE void Chip8<Byte, Word, Core, Instrument, Quirks>::decode(
+            Opcode op, const Instr& instr)
     {
         Byte        tmp; // used for sum and sub
-        auto instr = getOpcode(opcode);
 
-        // Only if DEBUG is set
-        prettyPrint(instr, opcode);
+        instrument_.instruction((pc_ - 2) & 0x0FFF, op);
 
-        switch (instr)
+        switch (op)
         {
             case CLEAR:
                 // 00E0 - Clear screen
-                screen_.fill(false);
-                drawFlag_ = false;
+                dirty_ |= screen_.clear();
+                break;
+            case SCROLL_DOWN:
+                // 00CN - Scrolls the screen down by N rows
+                dirty_ |= screen_.scrollDown(instr.nn & 0x000F);
+                break;
+            case SCROLL_UP:
+                // 00DN - Scrolls the selected planes up by N rows
+                dirty_ |= screen_.scrollUp(instr.nn & 0x000F);
+                break;
+            case SCROLL_RIGHT:
+                // 00FB - Scrolls the screen right by 4 pixels
+                dirty_ |= screen_.scrollRight();
+                break;
+            case SCROLL_LEFT:
+                // 00FC - Scrolls the screen left by 4 pixels
+                dirty_ |= screen_.scrollLeft();
+                break;
+            case EXIT:
+                // 00FD - Exits the interpreter, which then stays on it
+                pc_ = (pc_ - 2) & 0x0FFF;
+                break;
+            case LOW_RES:
+                // 00FE - Switches to the 64x32 low resolution, clearing
+                // the screen
+                dirty_ |= screen_.resize(false);
+                break;
+            case HIGH_RES:
+                // 00FF - Switches to the 128x64 high resolution, clearing
+                // the screen
+                dirty_ |= screen_.resize(true);
                 break;
             case RETURNS:
                 // 00EE - Returns from a subroutine
-                --sp_;
+                sp_ = (sp_ - 1) & 15;
                 pc_ = stack_[sp_];
                 break;
             case JUMP:
                 // 1NNN - Jumps to address NNN
-                pc_ = opcode & 0x0FFF;
+                pc_ = instr.nnn;
                 break;
             case CALL:
                 // 2NNN - Calls subroutine at NNN
-                stack_[sp_++] = pc_;
-                pc_ = (opcode & 0x0FFF);
+                instrument_.call(instr.nnn);
+                stack_[sp_] = pc_;
+                sp_ = (sp_ + 1) & 15;
+                pc_ = instr.nnn;
                 break;
             case SKIPS_EQ_XNN:
                 // 3XNN - Skips the next instruction if VX equals NN
-                if (registers_[get<1>(opcode)] == (opcode & 0x00FF))
-                    pc_ += 2;
+                if (registers_[instr.x] == instr.nn)
+                    skip();
                 break;
             case SKIPS_NEQ_XNN:
                 // 4XNN - Skips the next instruction if VX doesn't equal NN
-                if (registers_[get<1>(opcode)] != (opcode & 0x00FF))
-                    pc_ += 2;
+                if (registers_[instr.x] != instr.nn)
+                    skip();
                 break;
             case SKIPS_EQ_XY:
                 // 5XY0 - Skips the next instruction if VX equals VY
-                if (registers_[get<1>(opcode)] == registers_[get<2>(opcode)])
-                    pc_ += 2;
+                if (registers_[instr.x] == registers_[instr.y])
+                    skip();
                 break;
             case SKIPS_NEQ_XY:
                 // 9XY0 - Skips the next instruction if VX doesn't equal VY
-                if (registers_[get<1>(opcode)] != registers_[get<2>(opcode)])
-                    pc_ += 2;
+                if (registers_[instr.x] != registers_[instr.y])
+                    skip();
                 break;
+            case STORE_XY:
+            case FILLS_XY:
+            {
+                // 5XY2 - Stores VX to VY in memory starting at address I
+                // 5XY3 - Fills VX to VY with values from memory starting
+                // at address I
+                // Registers go backwards if X is greater than Y, and I
+                // doesn't change
+                int step = instr.x <= instr.y ? 1 : -1;
+                for (int x = instr.x, i = 0; ; x += step, ++i)
+                {
+                    if (op == STORE_XY)
+                        store(I_ + i, registers_[x]);
+                    else
+                        registers_[x] = memory_[Word(I_ + i)];
+                    if (x == instr.y)
+                        break;
+                }
+                break;
+            }
             case SET_XNN:
                 // 6XNN - Sets VX to NN
-                registers_[get<1>(opcode)] = opcode & 0x00FF;
+                registers_[instr.x] = instr.nn;
                 break;
             case ADD_XNN:
                 // 7XNN - Adds NN to VX
-                registers_[get<1>(opcode)] += opcode & 0x00FF;
+                registers_[instr.x] += instr.nn;
                 break;
             case SET_XY:
                 // 8XY0 - Sets VX to the value of VY
-                registers_[get<1>(opcode)] = registers_[get<2>(opcode)];
+                registers_[instr.x] = registers_[instr.y];
                 break;
             case SET_OR_XY:
                 // 8XY1 - Sets VX to VX or VY
-                registers_[get<1>(opcode)] |= registers_[get<2>(opcode)];
+                registers_[instr.x] |= registers_[instr.y];
+                if (Quirks::logicResetsVF)
+                    registers_[15] = 0;
                 break;
             case SET_AND_XY:
                 // 8XY2 - Sets VX to VX and VY
-                registers_[get<1>(opcode)] &= registers_[get<2>(opcode)];
+                registers_[instr.x] &= registers_[instr.y];
+                if (Quirks::logicResetsVF)
+                    registers_[15] = 0;
                 break;
             case SET_XOR_XY:
                 // 8XY3 - Sets VX to VX xor VY
-                registers_[get<1>(opcode)] ^= registers_[get<2>(opcode)];
+                registers_[instr.x] ^= registers_[instr.y];
+                if (Quirks::logicResetsVF)
+                    registers_[15] = 0;
                 break;
             case ADD_CARRY_XY:
                 // 8XY4 - Adds VY to VX. VF is set to 1 when there's a
                 // carry, and to 0 when there isn't
-                tmp = registers_[get<1>(opcode)] + registers_[get<2>(opcode)];
-                registers_[15] = tmp < registers_[get<1>(opcode)];
-                registers_[get<1>(opcode)] = tmp;
+                tmp = registers_[instr.x] + registers_[instr.y];
+                registers_[15] = tmp < registers_[instr.x];
+                registers_[instr.x] = tmp;
                 break;
             case SUB_BORROW_XY:
                 // 8XY5 - VY is subtracted from VX. VF is set to 0 when
                 // there's a borrow, and 1 when there isn't
-                tmp = registers_[get<1>(opcode)] - registers_[get<2>(opcode)];
-                registers_[15] = tmp < registers_[get<1>(opcode)];
-                registers_[get<1>(opcode)] = tmp;
+                tmp = registers_[instr.x] - registers_[instr.y];
+                registers_[15] = tmp < registers_[instr.x];
+                registers_[instr.x] = tmp;
                 break;
             case SHIFT_RIGHT_X:
-                // 8XY6 - Shifts VX right by one. VF is set to the value
-                // of the least significant bit of VX before the shift
-                registers_[15] = registers_[get<1>(opcode)] & 0x1;
-                registers_[get<1>(opcode)] >>= 1;
+                // 8XY6 - Shifts VX (or VY into VX) right by one. VF is set
+                // to the value of the least significant bit before the shift
+                if (Quirks::shiftsVY)
+                {
+                    tmp = registers_[instr.y];
+                    registers_[15] = tmp & 0x1;
+                    registers_[instr.x] = tmp >> 1;
+                }
+                else
+                {
+                    registers_[15] = registers_[instr.x] & 0x1;
+                    registers_[instr.x] >>= 1;
+                }
                 break;
             case SHIFT_LEFT_X:
-                // 8XYE - Shifts VX left by one. VF is set to the value
-                // of the most significant bit of VX before the shift
-                registers_[15] = registers_[get<1>(opcode)] >> 7;
-                registers_[get<1>(opcode)] <<= 1;
+                // 8XYE - Shifts VX (or VY into VX) left by one. VF is set
+                // to the value of the most significant bit before the shift
+                if (Quirks::shiftsVY)
+                {
+                    tmp = registers_[instr.y];
+                    registers_[15] = tmp >> 7;
+                    registers_[instr.x] = tmp << 1;
+                }
+                else
+                {
+                    registers_[15] = registers_[instr.x] >> 7;
+                    registers_[instr.x] <<= 1;
+                }
                 break;
             case SUB_BORROW_YX:
                 // 8XY7 - Sets VX to VY minus VX. VF is set to 0 when
                 // there's a borrow, and 1 when there isn't
-                tmp = registers_[get<2>(opcode)] - registers_[get<1>(opcode)];
-                registers_[15] = tmp < registers_[get<2>(opcode)];
-                registers_[get<1>(opcode)] = tmp ;
+                tmp = registers_[instr.y] - registers_[instr.x];
+                registers_[15] = tmp < registers_[instr.y];
+                registers_[instr.x] = tmp ;
                 break;
             case SET_INN:
                 // ANNN - Sets I to the address NNN
-                I_ = opcode & 0x0FFF;
+                I_ = instr.nnn;
                 break;
             case JUMP_0NNN:
-                // BNNN - Jumps to the address NNN plus V0
-                pc_ = (opcode & 0x0FFF) + registers_[0];
+                // BNNN - Jumps to the address NNN plus V0, or XNN plus VX
+                pc_ = (instr.nnn + registers_[Quirks::jumpsVX ? instr.x : 0])
+                    & 0x0FFF;
                 break;
             case RAND:
                 // CXNN - Sets VX to a random number and NN
-                registers_[get<1>(opcode)] = (rand() % 0xFF) & (opcode & 0x00FF);
+                registers_[instr.x] = (random_.next() >> 24) & instr.nn;
                 break;
             case DRAW:
                 // DXYN - Draws a sprite at coordinate (VX, VY) that has
@@ -325,60 +1049,82 @@ namespace chip8
                 // As described above, VF is set to 1 if any screen
                 // pixels are flipped from set to unset when the sprite
                 // is drawn, and to 0 if that doesn't happen
-                drawSprite(opcode);
-                drawFlag_ = true;
+                drawSprite(instr);
                 break;
             case SKIPS_PRESS:
                 // EX9E - Skips the next instruction if the key stored in VX is pressed
-                if (key_[registers_[get<1>(opcode)]])
-				{
-					key_[registers_[get<1>(opcode)]] = false;
-                    pc_ += 2;
-				}
+                if (key_[registers_[instr.x] & 0x0F])
+                    skip();
                 break;
             case SKIPS_NPRESS:
                 // EXA1 - Skips the next instruction if the key stored in VX isn't pressed
-                if (!key_[registers_[get<1>(opcode)]])
-                    pc_ += 2;
-				else
-					key_[registers_[get<1>(opcode)]] = false;
+                if (!key_[registers_[instr.x] & 0x0F])
+                    skip();
                 break;
             case SET_XTIMER:
                 // FX07 - Sets VX to the value of the delay timer
-                registers_[get<1>(opcode)] = delay_timer_;
+                registers_[instr.x] = delay_timer_;
                 break;
             case KEY_AWAIT:
                 // FX0A - A key press is awaited, and then stored in VX
-                pc_ -= 2;
-                for (unsigned n = 0; n < 16; ++n)
+                // once the key is released. Until then, FX0A runs again
+                if (await_ & AWAIT_RELEASED)
                 {
-                    if (key_[n])
-                    {
-                        registers_[get<1>(opcode)] = n;
-                        key_[n] = false;
-                        pc_ += 2;
-                        break;
-                    }
+                    registers_[instr.x] = await_ & 0x0F;
+                    await_ = AWAIT_IDLE;
+                }
+                else
+                {
+                    if (await_ == AWAIT_IDLE)
+                        await_ = AWAIT_PRESS;
+                    pc_ = (pc_ - 2) & 0x0FFF;
                 }
                 break;
             case SET_TIMERX:
                 // FX15 - Sets the delay timer to VX
-                delay_timer_ = registers_[get<1>(opcode)];
+                delay_timer_ = registers_[instr.x];
                 break;
             case SET_SOUNDX:
                 // FX18 - Sets the sound timer to VX
-                sound_timer_ = registers_[get<1>(opcode)];
+                sound_timer_ = registers_[instr.x];
                 break;
             case ADD_IX:
                 // FX1E - Adds VX to I
-                I_ += registers_[get<1>(opcode)];
-                registers_[15] = I_ > 0xFFF;
+                I_ += registers_[instr.x];
+                if (Quirks::addIndexSetsVF)
+                    registers_[15] = I_ > 0xFFF;
+                break;
+            case SET_I_LONG:
+                // F000 NNNN - Sets I to the address NNNN, read from the
+                // next two bytes
+                I_ = (memory_[pc_] << 8) | memory_[(pc_ + 1) & 0x0FFF];
+                pc_ = (pc_ + 2) & 0x0FFF;
+                break;
+            case SET_PLANE:
+                // FN01 - Selects the planes N (a mask, 3 for both) that
+                // drawing, clearing and scrolling affect
+                screen_.setPlanes(instr.x);
+                break;
+            case SET_PATTERN:
+                // F002 - Loads the audio pattern from the 16 bytes at
+                // address I
+                for (unsigned i = 0; i < pattern_.size(); ++i)
+                    pattern_[i] = memory_[Word(I_ + i)];
+                break;
+            case SET_PITCHX:
+                // FX3A - Sets the pitch of the audio pattern to VX
+                pitch_ = registers_[instr.x];
                 break;
             case SET_I_SPRITE:
                 // FX29 - Sets I to the location of the sprite for the character
                 // in VX. Characters 0-F (in hexadecimal) are represented by a
                 // 4x5 font
-                I_ = registers_[get<1>(opcode)] * 0x5;
+                I_ = registers_[instr.x] * 0x5;
+                break;
+            case SET_I_BIG_SPRITE:
+                // FX30 - Sets I to the location of the 8x10 sprite for the
+                // character in VX
+                I_ = BIG_FONT_ADDRESS + (registers_[instr.x] & 0xF) * 10;
                 break;
             case STORE_BINARY:
                 // FX33 - Stores the Binary-coded decimal representation of VX,
@@ -387,25 +1133,39 @@ namespace chip8
                 // at I plus 2. (In other words, take the decimal representation
                 // of VX, place the hundreds digit in memory at location in I, the
                 // tens digit at location I+1, and the ones digit at location I+2.)
-                memory_[I_]     = registers_[(opcode & 0x0F00) >> 8] / 100;
-                memory_[I_ + 1] = (registers_[(opcode & 0x0F00) >> 8] / 10) % 10;
-                memory_[I_ + 2] = (registers_[(opcode & 0x0F00) >> 8] % 100) % 10;
+                store(I_,     registers_[instr.x] / 100);
+                store(I_ + 1, (registers_[instr.x] / 10) % 10);
+                store(I_ + 2, (registers_[instr.x] % 100) % 10);
                 break;
             case STORE_0X:
                 // FX55 - Stores V0 to VX in memory starting at address I
-                for (unsigned i = 0; i <= get<1>(opcode); ++i)
-                    memory_[i + I_] = registers_[i];
-				I_ += get<1>(opcode) + 1;
+                for (unsigned i = 0; i <= instr.x; ++i)
+                    store(i + I_, registers_[i]);
+                if (Quirks::memoryIncrementsI)
+                    I_ += instr.x + !Quirks::memoryIncrementsByX;
                 break;
             case FILLS_0X:
                 // FX65 - Fills V0 to VX with values from memory starting at address I
-                for (unsigned i = 0; i <= get<1>(opcode); ++i)
-                    registers_[i] = memory_[i + I_];
-				I_ += get<1>(opcode) + 1;
+                for (unsigned i = 0; i <= instr.x; ++i)
+                    registers_[i] = memory_[Word(i + I_)];
+                if (Quirks::memoryIncrementsI)
+                    I_ += instr.x + !Quirks::memoryIncrementsByX;
+                break;
+            case STORE_FLAGS_0X:
+                // FX75 - Stores V0 to VX in the RPL user flags
+                for (unsigned i = 0; i <= instr.x; ++i)
+                    flags_[i] = registers_[i];
+                break;
+            case FILLS_FLAGS_0X:
+                // FX85 - Fills V0 to VX from the RPL user flags
+                for (unsigned i = 0; i <= instr.x; ++i)
+                    registers_[i] = flags_[i];
                 break;
             default:
                 break;
         };
+
+        instrument_.retire(*this, instr);
     }
 }
 
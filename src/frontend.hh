@@ -0,0 +1,222 @@
+#ifndef FRONTEND_HH_
+# define FRONTEND_HH_
+
+# include <algorithm>
+# include <array>
+# include <cstdint>
+# include <cstdlib>
+# include <SFML/Audio.hpp>
+# include <SFML/Graphics.hpp>
+# include "audio.hh"
+# include "screen.hh"
+# include "utility.hh"
+
+namespace chip8
+{
+    /// @class Renderer
+    /// @brief Draws the Chip8 screen as a single scaled sprite, backed by a
+    /// texture uploaded once per frame, of which only the part covering the
+    /// current resolution is shown. Pixels take one of four colors, after
+    /// the planes they are lit on
+    class Renderer
+    {
+        public:
+            // Size of the window, in low resolution pixels
+            static const unsigned WIDTH = Screen::WIDTH / 2;
+            static const unsigned HEIGHT = Screen::HEIGHT / 2;
+
+            explicit Renderer(unsigned scale = 10,
+                              sf::Color foreground = sf::Color::White,
+                              sf::Color background = sf::Color::Black,
+                              sf::Color second = sf::Color(0xFF, 0x66, 0x00),
+                              sf::Color both = sf::Color(0x66, 0x22, 0x00));
+
+            // Convert the given rows (bit y for row y) of the screen of
+            // machine and upload them, or all of them when its resolution
+            // changed
+            template <typename Machine>
+            void update(const Machine& machine,
+                        std::uint64_t rows = ~std::uint64_t(0));
+            void draw(sf::RenderWindow& window) const;
+
+            unsigned scale() const { return scale_; }
+
+        private:
+            // Show a screen of the given size
+            void resize(unsigned width, unsigned height);
+
+            unsigned                                scale_;
+            unsigned                                width_; // Shown
+            unsigned                                height_;
+            sf::Color                               palette_[4]; // By planes
+            // RGBA, rows being width_ pixels apart
+            std::array<sf::Uint8, Screen::WIDTH * Screen::HEIGHT * 4> pixels_;
+            sf::Texture                             texture_;
+            sf::Sprite                              sprite_;
+    };
+
+
+    /// @class AudioOutput
+    /// @brief Plays an Audio from the thread of SFML's sound stream, in
+    /// short chunks so that sound lags little behind the emulation. An
+    /// underrun is padded with silence rather than waited for
+    class AudioOutput : public sf::SoundStream
+    {
+        public:
+            explicit AudioOutput(Audio& audio);
+            ~AudioOutput();
+
+        private:
+            static const unsigned   CHUNK = 512; // Samples
+
+            bool onGetData(Chunk& data) override;
+            void onSeek(sf::Time) override {}
+
+            Audio&                  audio_;
+            sf::Int16               samples_[CHUNK];
+    };
+
+
+    inline Renderer::Renderer(unsigned scale, sf::Color foreground,
+                              sf::Color background, sf::Color second,
+                              sf::Color both)
+        : scale_(scale)
+        , width_(0)
+        , height_(0)
+    {
+        palette_[0] = background;
+        palette_[1] = foreground;
+        palette_[2] = second;
+        palette_[3] = both;
+
+        for (unsigned i = 0; i < pixels_.size(); i += 4)
+        {
+            pixels_[i]     = background.r;
+            pixels_[i + 1] = background.g;
+            pixels_[i + 2] = background.b;
+            pixels_[i + 3] = background.a;
+        }
+
+        texture_.create(Screen::WIDTH, Screen::HEIGHT);
+        texture_.update(pixels_.data());
+        sprite_.setTexture(texture_);
+        resize(WIDTH, HEIGHT);
+    }
+
+
+    inline void Renderer::resize(unsigned width, unsigned height)
+    {
+        float scale = static_cast<float>(scale_ * WIDTH) / width;
+
+        width_ = width;
+        height_ = height;
+        sprite_.setTextureRect(sf::IntRect(0, 0, width, height));
+        sprite_.setScale(scale, scale);
+    }
+
+
+    template <typename Machine>
+    void Renderer::update(const Machine& machine, std::uint64_t rows)
+    {
+        const Screen& screen = machine.screen();
+
+        if (screen.width() != width_)
+        {
+            resize(screen.width(), screen.height());
+            rows = ~std::uint64_t(0) >> (Screen::HEIGHT - height_);
+        }
+        if (rows == 0)
+            return;
+
+        unsigned first = lowestBit(rows);
+        unsigned last = first;
+
+        for (; rows != 0; rows &= rows - 1)
+        {
+            unsigned    y = lowestBit(rows);
+            sf::Uint8*  pixel = &pixels_[y * width_ * 4];
+
+            last = y;
+            for (unsigned x = 0; x < width_; ++x)
+            {
+                const sf::Color& color = palette_[screen.pixel(x, y)];
+                *pixel++ = color.r;
+                *pixel++ = color.g;
+                *pixel++ = color.b;
+                *pixel++ = color.a;
+            }
+        }
+
+        // One upload covering every changed row
+        texture_.update(&pixels_[first * width_ * 4], width_, last - first + 1,
+                        0, first);
+    }
+
+
+    inline void Renderer::draw(sf::RenderWindow& window) const
+    {
+        window.draw(sprite_);
+    }
+
+
+    inline AudioOutput::AudioOutput(Audio& audio)
+        : audio_(audio)
+    {
+        initialize(1, Audio::RATE);
+    }
+
+
+    inline AudioOutput::~AudioOutput()
+    {
+        stop();
+    }
+
+
+    inline bool AudioOutput::onGetData(Chunk& data)
+    {
+        std::size_t n = audio_.read(samples_, CHUNK);
+
+        std::fill(samples_ + n, samples_ + CHUNK, 0);
+        data.samples = samples_;
+        data.sampleCount = CHUNK;
+        return true;
+    }
+
+
+    // Color from an RRGGBB hexadecimal string
+    inline sf::Color parseColor(const char* rgb)
+    {
+        unsigned long value = std::strtoul(rgb, nullptr, 16);
+
+        return sf::Color((value >> 16) & 0xFF, (value >> 8) & 0xFF,
+                         value & 0xFF);
+    }
+
+
+    // Chip8 key of a keyboard key, 16 if none
+    inline unsigned keyOf(sf::Keyboard::Key code)
+    {
+        switch (code)
+        {
+            case sf::Keyboard::Num1: return 0;
+            case sf::Keyboard::Num2: return 1;
+            case sf::Keyboard::Num3: return 2;
+            case sf::Keyboard::Num4: return 3;
+            case sf::Keyboard::Q:    return 4;
+            case sf::Keyboard::W:    return 5;
+            case sf::Keyboard::E:    return 6;
+            case sf::Keyboard::R:    return 7;
+            case sf::Keyboard::A:    return 8;
+            case sf::Keyboard::S:    return 9;
+            case sf::Keyboard::D:    return 10;
+            case sf::Keyboard::F:    return 11;
+            case sf::Keyboard::Z:    return 12;
+            case sf::Keyboard::X:    return 13;
+            case sf::Keyboard::C:    return 14;
+            case sf::Keyboard::V:    return 15;
+            default:                 return 16;
+        }
+    }
+}
+
+#endif /* !FRONTEND_HH_ */
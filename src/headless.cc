@@ -0,0 +1,301 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include "chip8.hh"
+#include "headless.hh"
+#include "mapped_file.hh"
+#include "trace.hh"
+
+namespace
+{
+    struct Options
+    {
+        const char*     rom = nullptr;
+        const char*     input = nullptr;
+        const char*     replay = nullptr;
+        const char*     loadState = nullptr;
+        const char*     saveState = nullptr;
+        const char*     profile = nullptr;
+        const char*     trace = nullptr;
+        const char*     audio = nullptr;
+        const char*     core = "threaded";
+        const char*     quirks = "default";
+        const char*     dump = "hash";
+        bool            frameLog = false;
+        unsigned long   cycles = 0;
+        unsigned long   frames = 600;
+        unsigned        cyclesPerFrame = 10;
+        std::uint64_t   seed = 0;
+    };
+
+
+    int usage(const char* name)
+    {
+        std::cerr << "usage: " << name << " [ROM] [options]\n"
+            "  --cycles N            instructions to execute\n"
+            "  --frames N            60 Hz frames to execute (default 600)\n"
+            "  --cycles-per-frame N  instructions per frame (default 10)\n"
+            "  --input FILE          scripted key presses, \"FRAME KEY [FRAMES]\"\n"
+            "                        lines, FRAMES being how long it is held\n"
+            "  --seed N              seed of the random generator (default 0)\n"
+            "  --replay FILE         replay a movie recorded by chip8 --record\n"
+            "  --load-state FILE     start from a saved state instead of ROM\n"
+            "  --save-state FILE     save the final state\n"
+            "  --core NAME           switch, threaded or jit (default threaded)\n"
+            "  --quirks NAME         default, vip, chip48, schip or modern\n"
+            "  --dump WHAT           hash, state or screen (default hash)\n"
+            "  --frame-log           print \"FRAME ROWS HASH\" for every frame\n"
+            "                        that changed the screen\n"
+            "  --audio FILE          write the sound as raw 16 bit mono\n"
+            "                        samples at 48 kHz to FILE\n"
+            "  --profile FILE        count instructions by opcode and address,\n"
+            "                        without the JIT, and write them to FILE\n"
+            "  --trace FILE          write every instruction executed to FILE,\n"
+            "                        without the JIT, for chip8-tracedump\n";
+        return 1;
+    }
+
+
+    // Start instrumenting a session, with path as output
+    template <typename Instrument>
+    bool startInstrument(Instrument&, const char*, std::uint64_t)
+    {
+        return true;
+    }
+
+
+    bool startInstrument(chip8::Trace& trace, const char* path,
+                         std::uint64_t cycle)
+    {
+        return trace.open(path, cycle);
+    }
+
+
+    // Write the output of the instrumentation of a session to path
+    template <typename Instrument>
+    bool finishInstrument(Instrument& instrument, const char* path)
+    {
+        std::ofstream ofs(path);
+
+        instrument.report(ofs);
+        return ofs.good();
+    }
+
+
+    bool finishInstrument(chip8::Trace& trace, const char*)
+    {
+        return trace.close();
+    }
+
+
+    template <typename Core, typename Instrument, typename Quirks>
+    int run(const Options& options)
+    {
+        chip8::Chip8<unsigned char, unsigned short, Core, Instrument, Quirks>
+            chip8;
+        chip8::InputScript input;
+        chip8::Movie movie(options.seed);
+
+        if (options.input != nullptr && !input.load(options.input))
+        {
+            std::cerr << "Invalid input script: " << options.input << std::endl;
+            return 1;
+        }
+        if (options.replay != nullptr && !movie.load(options.replay))
+        {
+            std::cerr << "Invalid movie: " << options.replay << std::endl;
+            return 1;
+        }
+
+        chip8.initialize(movie.seed());
+        if (options.loadState != nullptr)
+        {
+            chip8::MappedFile state;
+
+            if (!state.open(options.loadState)
+                || !chip8.loadState(state.data(), state.size()))
+            {
+                std::cerr << "Invalid state: " << options.loadState << std::endl;
+                return 1;
+            }
+        }
+        else if (!chip8.loadGame(options.rom))
+        {
+            std::cerr << "Invalid ROM: " << options.rom << std::endl;
+            return 1;
+        }
+
+        const char* output = options.profile != nullptr
+            ? options.profile
+            : options.trace;
+        if (output != nullptr
+            && !startInstrument(chip8.instrument(), output, chip8.cycles()))
+        {
+            std::cerr << "Cannot write " << output << std::endl;
+            return 1;
+        }
+
+        unsigned long cycles = options.cycles != 0
+            ? options.cycles
+            : options.frames * options.cyclesPerFrame;
+        std::ostream* frameLog = options.frameLog ? &std::cout : nullptr;
+        std::ofstream audio;
+        if (options.audio != nullptr)
+        {
+            audio.open(options.audio, std::ios::binary);
+            if (!audio)
+            {
+                std::cerr << "Cannot write " << options.audio << std::endl;
+                return 1;
+            }
+        }
+
+        std::ostream* audioLog = audio.is_open() ? &audio : nullptr;
+        auto result = options.replay != nullptr
+            ? chip8::replayMovie(chip8, movie, frameLog, audioLog)
+            : chip8::runSession(chip8, input, cycles, options.cyclesPerFrame,
+                                frameLog, audioLog);
+
+        std::cout << std::hex << std::setfill('0');
+        if (std::strcmp(options.dump, "screen") == 0)
+        {
+            const chip8::Screen& screen = chip8.screen();
+            // Pixel lit on no plane, the first, the second or both
+            const char* const pixels = ".#+@";
+
+            for (unsigned y = 0; y < screen.height(); ++y)
+            {
+                for (unsigned x = 0; x < screen.width(); ++x)
+                    std::cout << pixels[screen.pixel(x, y)];
+                std::cout << '\n';
+            }
+        }
+        else if (std::strcmp(options.dump, "state") == 0)
+        {
+            for (unsigned i = 0; i < 16; ++i)
+                std::cout << 'V' << i << '=' << std::setw(2)
+                    << unsigned(chip8.registers()[i]) << ' ';
+            std::cout << "I=" << std::setw(4) << chip8.index()
+                << " PC=" << std::setw(4) << chip8.pc()
+                << " DT=" << std::setw(2) << unsigned(chip8.delayTimer())
+                << " ST=" << std::setw(2) << unsigned(chip8.soundTimer())
+                << '\n';
+        }
+
+        if (options.saveState != nullptr)
+        {
+            chip8::Snapshot snapshot;
+
+            chip8.saveState(snapshot);
+            if (!chip8::writeSnapshot(options.saveState, snapshot))
+            {
+                std::cerr << "Cannot save state: " << options.saveState
+                    << std::endl;
+                return 1;
+            }
+        }
+
+        if (output != nullptr && !finishInstrument(chip8.instrument(), output))
+        {
+            std::cerr << "Cannot write " << output << std::endl;
+            return 1;
+        }
+
+        std::cout << "screen=" << std::setw(16) << result.screenHash
+            << " state=" << std::setw(16) << result.stateHash
+            << std::dec
+            << " frames=" << result.frames
+            << " cycles=" << result.cycles
+            << " seconds=" << result.seconds << std::endl;
+        return 0;
+    }
+
+
+    template <typename Core, typename Quirks>
+    int run(const Options& options)
+    {
+        if (options.profile != nullptr)
+            return run<Core, chip8::Profile, Quirks>(options);
+        if (options.trace != nullptr)
+            return run<Core, chip8::Trace, Quirks>(options);
+        return run<Core, chip8::NoProfile, Quirks>(options);
+    }
+
+
+    template <typename Core>
+    int run(const Options& options)
+    {
+        if (std::strcmp(options.quirks, "default") == 0)
+            return run<Core, chip8::DefaultQuirks>(options);
+        if (std::strcmp(options.quirks, "vip") == 0)
+            return run<Core, chip8::VipQuirks>(options);
+        if (std::strcmp(options.quirks, "chip48") == 0)
+            return run<Core, chip8::Chip48Quirks>(options);
+        if (std::strcmp(options.quirks, "schip") == 0)
+            return run<Core, chip8::SChipQuirks>(options);
+        if (std::strcmp(options.quirks, "modern") == 0)
+            return run<Core, chip8::ModernQuirks>(options);
+
+        std::cerr << "Unknown quirks: " << options.quirks << std::endl;
+        return 1;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--cycles") == 0 && hasValue)
+            options.cycles = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+            options.frames = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--cycles-per-frame") == 0 && hasValue)
+            options.cyclesPerFrame = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--input") == 0 && hasValue)
+            options.input = argv[++i];
+        else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+            options.seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--replay") == 0 && hasValue)
+            options.replay = argv[++i];
+        else if (std::strcmp(argv[i], "--load-state") == 0 && hasValue)
+            options.loadState = argv[++i];
+        else if (std::strcmp(argv[i], "--save-state") == 0 && hasValue)
+            options.saveState = argv[++i];
+        else if (std::strcmp(argv[i], "--core") == 0 && hasValue)
+            options.core = argv[++i];
+        else if (std::strcmp(argv[i], "--quirks") == 0 && hasValue)
+            options.quirks = argv[++i];
+        else if (std::strcmp(argv[i], "--dump") == 0 && hasValue)
+            options.dump = argv[++i];
+        else if (std::strcmp(argv[i], "--profile") == 0 && hasValue)
+            options.profile = argv[++i];
+        else if (std::strcmp(argv[i], "--trace") == 0 && hasValue)
+            options.trace = argv[++i];
+        else if (std::strcmp(argv[i], "--frame-log") == 0)
+            options.frameLog = true;
+        else if (std::strcmp(argv[i], "--audio") == 0 && hasValue)
+            options.audio = argv[++i];
+        else if (argv[i][0] != '-' && options.rom == nullptr)
+            options.rom = argv[i];
+        else
+            return usage(argv[0]);
+    }
+
+    if ((options.rom == nullptr && options.loadState == nullptr)
+        || (options.profile != nullptr && options.trace != nullptr)
+        || options.cyclesPerFrame == 0)
+        return usage(argv[0]);
+
+    if (std::strcmp(options.core, "switch") == 0)
+        return run<chip8::SwitchCore>(options);
+    else if (std::strcmp(options.core, "threaded") == 0)
+        return run<chip8::ThreadedCore>(options);
+    else if (std::strcmp(options.core, "jit") == 0)
+        return run<chip8::JitCore>(options);
+    return usage(argv[0]);
+}
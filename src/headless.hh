@@ -0,0 +1,313 @@
+#ifndef HEADLESS_HH_
+# define HEADLESS_HH_
+
+# include <algorithm>
+# include <array>
+# include <chrono>
+# include <cstdint>
+# include <fstream>
+# include <ostream>
+# include <sstream>
+# include <string>
+# include <vector>
+# include "audio.hh"
+# include "input.hh"
+# include "movie.hh"
+# include "screen.hh"
+# include "utility.hh"
+
+namespace chip8
+{
+    /// @class InputScript
+    /// @brief Key presses scripted by frame, read from a text file holding
+    /// one "FRAME KEY [FRAMES]" line per press, KEY being an hexadecimal
+    /// digit held for FRAMES frames, 1 by default. Lines starting with '#'
+    /// are comments
+    class InputScript
+    {
+        public:
+            struct Event
+            {
+                unsigned long   frame;
+                unsigned        key;
+                bool            pressed;
+            };
+
+            bool load(const char* path);
+            void add(unsigned long frame, unsigned key,
+                     unsigned long frames = 1);
+
+            // Presses and releases sorted by frame
+            const std::vector<Event>& events() const { return events_; }
+
+        private:
+            void insert(const Event& event);
+
+            std::vector<Event>  events_;
+    };
+
+
+    /// @class FrameHasher
+    /// @brief Hash of the screen, kept up to date from its dirty rows only:
+    /// it is the XOR of the hashes of every row, salted by row index
+    class FrameHasher
+    {
+        public:
+            FrameHasher();
+
+            // Rehash the given rows (bit y for row y) of machine's screen
+            template <typename Machine>
+            std::uint64_t update(const Machine& machine, std::uint64_t rows);
+
+            std::uint64_t hash() const { return hash_; }
+
+        private:
+            std::array<std::uint64_t, Screen::HEIGHT> rows_;
+            std::uint64_t                   hash_;
+    };
+
+
+    /// @struct SessionResult
+    /// @brief Outcome of a headless run
+    struct SessionResult
+    {
+        unsigned long   frames;
+        unsigned long   cycles;
+        std::uint64_t   screenHash;
+        std::uint64_t   stateHash;
+        double          seconds;
+    };
+
+
+    inline bool InputScript::load(const char* path)
+    {
+        std::ifstream   ifs(path);
+        std::string     line;
+
+        if (!ifs)
+            return false;
+
+        while (std::getline(ifs, line))
+        {
+            std::istringstream  iss(line);
+            unsigned long       frame;
+            unsigned            key;
+            unsigned long       frames = 1;
+
+            if (line.empty() || line[0] == '#')
+                continue;
+            if (!(iss >> frame >> std::hex >> key) || key > 0xF)
+                return false;
+            // FRAMES is optional
+            if (!(iss >> std::dec >> frames))
+            {
+                if (!iss.eof())
+                    return false;
+                frames = 1;
+            }
+            if (frames == 0)
+                return false;
+            add(frame, key, frames);
+        }
+
+        return true;
+    }
+
+
+    inline void InputScript::add(unsigned long frame, unsigned key,
+                                 unsigned long frames)
+    {
+        Event press = { frame, key, true };
+        Event release = { frame + frames, key, false };
+
+        insert(press);
+        insert(release);
+    }
+
+
+    inline void InputScript::insert(const Event& event)
+    {
+        auto it = std::upper_bound(events_.begin(), events_.end(), event,
+                [](const Event& a, const Event& b)
+                {
+                    return a.frame < b.frame;
+                });
+
+        events_.insert(it, event);
+    }
+
+
+    inline FrameHasher::FrameHasher()
+        : hash_(0)
+    {
+        Screen::Row blank = Screen::Row();
+
+        for (unsigned y = 0; y < rows_.size(); ++y)
+        {
+            rows_[y] = fnv1a(&blank, sizeof (blank), fnv1a(&y, sizeof (y)));
+            hash_ ^= rows_[y];
+        }
+    }
+
+
+    template <typename Machine>
+    std::uint64_t FrameHasher::update(const Machine& machine,
+                                      std::uint64_t rows)
+    {
+        for (; rows != 0; rows &= rows - 1)
+        {
+            unsigned y = lowestBit(rows);
+
+            hash_ ^= rows_[y];
+            rows_[y] = fnv1a(&machine.screen()[y], sizeof (Screen::Row),
+                             fnv1a(&y, sizeof (y)));
+            hash_ ^= rows_[y];
+        }
+
+        return hash_;
+    }
+
+
+    // Hash of the screen alone, and of its resolution
+    template <typename Machine>
+    std::uint64_t screenHash(const Machine& machine)
+    {
+        const Screen&   screen = machine.screen();
+        std::uint8_t    hires = screen.hires();
+
+        return fnv1a(screen.rows().data(), sizeof (screen.rows()),
+                     fnv1a(&hires, sizeof (hires)));
+    }
+
+
+    // Log frame to frameLog as "FRAME ROWS HASH" if it changed the screen
+    template <typename Machine>
+    void logFrame(Machine& machine, FrameHasher& hasher, unsigned long frame,
+                  std::ostream* frameLog)
+    {
+        std::uint64_t rows;
+
+        if (frameLog != nullptr && (rows = machine.dirtyRows()) != 0)
+        {
+            *frameLog << std::dec << frame << ' '
+                << std::hex << rows << ' '
+                << hasher.update(machine, rows) << '\n';
+            machine.markPresented();
+        }
+    }
+
+
+    // Render the sound of the frame machine is ending to audioLog, as raw
+    // 16 bit mono samples at Audio::RATE, if set
+    template <typename Machine>
+    void logAudio(const Machine& machine, Audio& audio,
+                  std::ostream* audioLog)
+    {
+        std::int16_t samples[Audio::TICK];
+
+        if (audioLog != nullptr)
+        {
+            audio.tick(machine);
+            audioLog->write(reinterpret_cast<const char*>(samples),
+                            audio.read(samples, Audio::TICK)
+                            * sizeof (samples[0]));
+        }
+    }
+
+
+    // Run machine for the given number of cycles, updating timers every
+    // cyclesPerFrame cycles and pressing and releasing keys as scripted by
+    // input, at the start of their frame. When
+    // frameLog is set, every frame that changed the screen is logged there
+    // as "FRAME ROWS HASH", ROWS being the mask of changed rows. When
+    // audioLog is set, the sound of every frame is written there
+    template <typename Machine>
+    SessionResult runSession(Machine& machine, const InputScript& input,
+                             unsigned long cycles, unsigned cyclesPerFrame,
+                             std::ostream* frameLog = nullptr,
+                             std::ostream* audioLog = nullptr)
+    {
+        FrameHasher     hasher;
+        Audio           audio;
+        InputQueue      queue;
+        SessionResult   result = SessionResult();
+        auto            event = input.events().begin();
+        auto            start = std::chrono::steady_clock::now();
+
+        while (result.cycles < cycles)
+        {
+            unsigned long n = std::min<unsigned long>(cyclesPerFrame,
+                                                      cycles - result.cycles);
+
+            // Events of a frame too many for the queue wait for the next
+            for (; event != input.events().end()
+                   && event->frame <= result.frames; ++event)
+            {
+                KeyEvent key = { machine.cycles(), std::uint8_t(event->key),
+                                 event->pressed };
+
+                if (!queue.push(key))
+                    break;
+            }
+
+            runWithInput(machine, queue, n);
+            result.cycles += n;
+
+            // Timers only tick on complete frames
+            if (n == cyclesPerFrame)
+            {
+                logAudio(machine, audio, audioLog);
+                machine.updateTimers();
+                logFrame(machine, hasher, ++result.frames, frameLog);
+            }
+        }
+
+        result.seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        result.screenHash = screenHash(machine);
+        result.stateHash = machine.digest();
+        return result;
+    }
+
+
+    // Replay movie on machine, initialized with its seed and loaded with
+    // its game, as fast as possible. Frames are counted by timer ticks and
+    // logged to frameLog and audioLog like runSession() does
+    template <typename Machine>
+    SessionResult replayMovie(Machine& machine, const Movie& movie,
+                              std::ostream* frameLog = nullptr,
+                              std::ostream* audioLog = nullptr)
+    {
+        FrameHasher     hasher;
+        Audio           audio;
+        SessionResult   result = SessionResult();
+        std::uint64_t   start = machine.cycles();
+        auto            clock = std::chrono::steady_clock::now();
+
+        for (const Movie::Event& event : movie.events())
+        {
+            if (event.cycle > machine.cycles())
+                machine.run(event.cycle - machine.cycles());
+
+            if (event.code == Movie::TICK)
+            {
+                logAudio(machine, audio, audioLog);
+                machine.updateTimers();
+                logFrame(machine, hasher, ++result.frames, frameLog);
+            }
+            else if ((event.code & 0xF0) == Movie::PRESS)
+                machine.pressKey(event.code & 0x0F);
+            else if ((event.code & 0xF0) == Movie::RELEASE)
+                machine.releaseKey(event.code & 0x0F);
+        }
+
+        result.cycles = machine.cycles() - start;
+        result.seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - clock).count();
+        result.screenHash = screenHash(machine);
+        result.stateHash = machine.digest();
+        return result;
+    }
+}
+
+#endif /* !HEADLESS_HH_ */
@@ -0,0 +1,165 @@
+#ifndef INPUT_HH_
+# define INPUT_HH_
+
+# include <atomic>
+# include <cstdint>
+# include <vector>
+# include "movie.hh"
+
+namespace chip8
+{
+    // Progress of FX0A, which completes once a key is pressed then
+    // released: AWAIT_IDLE when not running, AWAIT_PRESS until a key is
+    // pressed, then that key Or'ed with AWAIT_HELD, then with AWAIT_RELEASED
+    static const std::uint8_t   AWAIT_IDLE = 0x00;
+    static const std::uint8_t   AWAIT_PRESS = 0x10;
+    static const std::uint8_t   AWAIT_HELD = 0x20;
+    static const std::uint8_t   AWAIT_RELEASED = 0x40;
+
+    // Next FX0A progress after key was pressed or released
+    inline std::uint8_t awaitPress(std::uint8_t await, unsigned key)
+    {
+        return await == AWAIT_PRESS ? AWAIT_HELD | key : await;
+    }
+
+    inline std::uint8_t awaitRelease(std::uint8_t await, unsigned key)
+    {
+        return await == (AWAIT_HELD | key) ? AWAIT_RELEASED | key : await;
+    }
+
+    // Whether await is one of the FX0A progress values above
+    inline bool awaitValid(std::uint8_t await)
+    {
+        return await == AWAIT_IDLE || await == AWAIT_PRESS
+            || (await & 0xF0) == AWAIT_HELD || (await & 0xF0) == AWAIT_RELEASED;
+    }
+
+
+    /// @struct KeyEvent
+    /// @brief Key going down or up, due when the machine reaches the given
+    /// cycles(), or right away when stamped before
+    struct KeyEvent
+    {
+        std::uint64_t   cycle;
+        std::uint8_t    key;
+        bool            pressed;
+    };
+
+
+    /// @class InputQueue
+    /// @brief Lock-free queue of key events from a single producer, e.g. a
+    /// frontend thread or a script, to the single thread running the
+    /// machine, which applies them between instructions with runWithInput().
+    /// Events pushed to a full queue are dropped
+    class InputQueue
+    {
+        public:
+            // capacity is rounded up to a power of two
+            explicit InputQueue(std::size_t capacity = 256);
+
+            // Producer
+            bool push(const KeyEvent& event);
+            bool press(unsigned key, std::uint64_t cycle = 0);
+            bool release(unsigned key, std::uint64_t cycle = 0);
+
+            // Consumer: oldest event, nullptr if none, until pop()
+            const KeyEvent* front() const;
+            void pop();
+
+        private:
+            std::vector<KeyEvent>       events_;
+            std::size_t                 mask_;
+            std::atomic<std::size_t>    head_; // Written by the producer
+            std::atomic<std::size_t>    tail_; // Written by the consumer
+    };
+
+
+    inline InputQueue::InputQueue(std::size_t capacity)
+        : mask_(0)
+        , head_(0)
+        , tail_(0)
+    {
+        std::size_t size = 1;
+
+        while (size < capacity)
+            size <<= 1;
+        events_.resize(size);
+        mask_ = size - 1;
+    }
+
+
+    inline bool InputQueue::push(const KeyEvent& event)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head - tail_.load(std::memory_order_acquire) == events_.size())
+            return false;
+
+        events_[head & mask_] = event;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    inline bool InputQueue::press(unsigned key, std::uint64_t cycle)
+    {
+        KeyEvent event = { cycle, std::uint8_t(key), true };
+        return key < 16 && push(event);
+    }
+
+
+    inline bool InputQueue::release(unsigned key, std::uint64_t cycle)
+    {
+        KeyEvent event = { cycle, std::uint8_t(key), false };
+        return key < 16 && push(event);
+    }
+
+
+    inline const KeyEvent* InputQueue::front() const
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (head_.load(std::memory_order_acquire) == tail)
+            return nullptr;
+        return &events_[tail & mask_];
+    }
+
+
+    inline void InputQueue::pop()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+
+    // Run machine for n instructions, applying every event of input due by
+    // then between the instructions it is due at, and recording them to
+    // movie if set. Events due later are left queued
+    template <typename Machine>
+    void runWithInput(Machine& machine, InputQueue& input, unsigned long n,
+                      Movie* movie = nullptr)
+    {
+        std::uint64_t end = machine.cycles() + n;
+
+        for (const KeyEvent* event; (event = input.front()) != nullptr
+                 && event->cycle <= end; input.pop())
+        {
+            if (event->cycle > machine.cycles())
+                machine.run(event->cycle - machine.cycles());
+
+            if (movie != nullptr)
+                movie->record(machine.cycles(), (event->pressed
+                                                 ? Movie::PRESS
+                                                 : Movie::RELEASE)
+                              | event->key);
+            if (event->pressed)
+                machine.pressKey(event->key);
+            else
+                machine.releaseKey(event->key);
+        }
+
+        machine.run(end - machine.cycles());
+    }
+}
+
+#endif /* !INPUT_HH_ */
@@ -0,0 +1,478 @@
+#ifndef JIT_HH_
+# define JIT_HH_
+
+# include <algorithm>
+# include <array>
+# include <vector>
+# include "opcodes.hh"
+
+# if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__)) \
+    && !defined(CHIP8_NO_JIT)
+#  define CHIP8_JIT
+#  include <sys/mman.h>
+# endif
+
+namespace chip8
+{
+    /// @brief Core compiling straight-line runs of instructions to native
+    /// x86-64 code, and interpreting everything else. Hosts without a
+    /// compiler backend run ThreadedCore instead
+    struct JitCore {};
+
+    /// @class NoJit
+    /// @brief Stand-in for Jit in cores that do not compile anything
+    struct NoJit
+    {
+        void invalidate(unsigned) {}
+        void flush() {}
+    };
+
+# ifdef CHIP8_JIT
+    /// @class Jit
+    /// @brief Block compiler and code cache for one Machine, whose
+    /// instructions behave as its Quirks policy says.
+    ///
+    /// Blocks start at any address and stop before the first instruction
+    /// that is not compiled (memory writes, DRAW, CALL, RETURNS, keys...),
+    /// which the interpreter runs, or after a JUMP or a skip, which are
+    /// compiled as the block exit. Generated code is called with the
+    /// Machine in rdi, addresses its registers relative to it, and writes
+    /// pc_ once when leaving the block.
+    template <typename Machine, typename Quirks>
+    class Jit
+    {
+        public:
+            typedef void (*Code)(Machine*);
+
+            struct Block
+            {
+                Code            code;
+                unsigned short  end; // First address after the block
+                unsigned short  length; // Number of instructions
+                bool            compiled;
+            };
+
+            Jit();
+            // Compiled code refers to offsets only, but a copy starts
+            // with an empty cache of its own
+            Jit(const Jit&);
+            Jit& operator=(const Jit&);
+            ~Jit();
+
+            // Block starting at pc, compiled on first use. An empty block
+            // means the instruction at pc has to be interpreted
+            const Block& lookup(Machine& machine, unsigned pc);
+            // Drop every block reading the byte at address
+            void invalidate(unsigned address);
+            // Drop every block
+            void flush();
+
+        private:
+            static const unsigned   MEMORY = 4096;
+            static const unsigned   PAGE = 256;
+            static const size_t     CODE_SIZE = 1 << 20;
+            static const unsigned   MAX_LENGTH = 64;
+            // Longest sequence emitted for one instruction
+            static const size_t     MAX_EMIT = 64;
+
+            void compile(Machine& machine, unsigned pc, Block& block);
+
+            // x86-64 encoding
+            void emit(unsigned char byte) { code_[used_++] = byte; }
+            void emit16(unsigned value);
+            void emit32(unsigned value);
+            // ModRM for [rdi + disp32], with reg in the reg field
+            void mem(unsigned reg, unsigned disp);
+            // Leave the block with pc_ set to the given address
+            void exit(unsigned pc);
+
+            unsigned char*                              code_;
+            size_t                                      used_;
+            std::vector<Block>                          blocks_;
+            // Start address of the blocks touching each page
+            std::array<std::vector<unsigned short>, MEMORY / PAGE> pages_;
+
+            // Offsets of the Machine state from its address
+            unsigned                                    V_;
+            unsigned                                    I_;
+            unsigned                                    pc_;
+            unsigned                                    delay_;
+            unsigned                                    sound_;
+    };
+
+
+    template <typename Machine, typename Quirks>
+    Jit<Machine, Quirks>::Jit()
+        : code_(nullptr)
+        , used_(0)
+    {
+    }
+
+
+    template <typename Machine, typename Quirks>
+    Jit<Machine, Quirks>::Jit(const Jit&)
+        : Jit()
+    {
+    }
+
+
+    template <typename Machine, typename Quirks>
+    Jit<Machine, Quirks>& Jit<Machine, Quirks>::operator=(const Jit&)
+    {
+        flush();
+        return *this;
+    }
+
+
+    template <typename Machine, typename Quirks>
+    Jit<Machine, Quirks>::~Jit()
+    {
+        if (code_ != nullptr)
+            munmap(code_, CODE_SIZE);
+    }
+
+
+    template <typename Machine, typename Quirks>
+    const typename Jit<Machine, Quirks>::Block&
+    Jit<Machine, Quirks>::lookup(Machine& machine, unsigned pc)
+    {
+        pc &= MEMORY - 1;
+
+        if (blocks_.empty())
+        {
+            blocks_.resize(MEMORY);
+            flush();
+        }
+
+        Block& block = blocks_[pc];
+        if (!block.compiled)
+            compile(machine, pc, block);
+
+        return block;
+    }
+
+
+    template <typename Machine, typename Quirks>
+    void Jit<Machine, Quirks>::invalidate(unsigned address)
+    {
+        address &= MEMORY - 1;
+        unsigned written = address / PAGE;
+        std::vector<unsigned short>& starts = pages_[written];
+
+        for (size_t i = 0; i < starts.size(); )
+        {
+            unsigned start = starts[i];
+            Block& block = blocks_[start];
+            if (start <= address && address < block.end)
+            {
+                block.compiled = false;
+                starts[i] = starts.back();
+                starts.pop_back();
+
+                // Also unlisted from its other pages, as compile() lists it
+                // again on each of them
+                for (unsigned page = start / PAGE;
+                     page <= (block.end - 1) / PAGE; ++page)
+                {
+                    std::vector<unsigned short>& others = pages_[page];
+                    auto it = std::find(others.begin(), others.end(), start);
+
+                    if (page != written && it != others.end())
+                    {
+                        *it = others.back();
+                        others.pop_back();
+                    }
+                }
+            }
+            else
+                ++i;
+        }
+    }
+
+
+    template <typename Machine, typename Quirks>
+    void Jit<Machine, Quirks>::flush()
+    {
+        for (auto& block : blocks_)
+            block.compiled = false;
+        for (auto& starts : pages_)
+            starts.clear();
+        used_ = 0;
+    }
+
+
+    template <typename Machine, typename Quirks>
+    void Jit<Machine, Quirks>::emit16(unsigned value)
+    {
+        emit(value & 0xFF);
+        emit((value >> 8) & 0xFF);
+    }
+
+
+    template <typename Machine, typename Quirks>
+    void Jit<Machine, Quirks>::emit32(unsigned value)
+    {
+        emit16(value & 0xFFFF);
+        emit16(value >> 16);
+    }
+
+
+    template <typename Machine, typename Quirks>
+    void Jit<Machine, Quirks>::mem(unsigned reg, unsigned disp)
+    {
+        emit(0x87 | (reg << 3));
+        emit32(disp);
+    }
+
+
+    template <typename Machine, typename Quirks>
+    void Jit<Machine, Quirks>::exit(unsigned pc)
+    {
+        emit(0x66); emit(0xC7); mem(0, pc_);                // mov [pc], pc
+        emit16(pc & 0x0FFF);
+        emit(0xC3);                                         // ret
+    }
+
+
+    template <typename Machine, typename Quirks>
+    void Jit<Machine, Quirks>::compile(Machine& machine, unsigned pc,
+                                       Block& block)
+    {
+        typedef typename Machine::Instr Instr;
+
+        block.code = nullptr;
+        block.end = pc;
+        block.length = 0;
+        block.compiled = true;
+
+        if (code_ == nullptr)
+        {
+            void* code = mmap(nullptr, CODE_SIZE,
+                              PROT_READ | PROT_WRITE | PROT_EXEC,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            // Without executable memory, everything is interpreted
+            if (code == MAP_FAILED)
+                return;
+            code_ = static_cast<unsigned char*>(code);
+        }
+
+        // Start over once the code cache is full
+        if (used_ + MAX_LENGTH * MAX_EMIT > CODE_SIZE)
+        {
+            flush();
+            block.compiled = true;
+        }
+
+        const char* base = reinterpret_cast<const char*>(&machine);
+        V_      = reinterpret_cast<const char*>(&machine.registers_) - base;
+        I_      = reinterpret_cast<const char*>(&machine.I_) - base;
+        pc_     = reinterpret_cast<const char*>(&machine.pc_) - base;
+        delay_  = reinterpret_cast<const char*>(&machine.delay_timer_) - base;
+        sound_  = reinterpret_cast<const char*>(&machine.sound_timer_) - base;
+
+        const size_t    start = used_;
+        const unsigned  VF = V_ + 15;
+        unsigned        address = pc;
+        unsigned        end = pc; // Past the last byte read
+        bool            open = true;
+
+        // Every instruction may read the next one too, as skips and
+        // F000 NNNN do
+        while (open && block.length < MAX_LENGTH && address + 3 < MEMORY)
+        {
+            Instr instr = predecode<unsigned char, unsigned short>(
+                    (machine.memory_[address] << 8)
+                    | machine.memory_[address + 1]);
+            unsigned X = V_ + instr.x;
+            unsigned Y = V_ + instr.y;
+            unsigned next = address + 2;
+
+            switch (instr.op)
+            {
+                case SET_XNN:
+                    emit(0xC6); mem(0, X); emit(instr.nn);  // mov [x], nn
+                    break;
+                case ADD_XNN:
+                    emit(0x80); mem(0, X); emit(instr.nn);  // add [x], nn
+                    break;
+                case SET_XY:
+                    emit(0x8A); mem(0, Y);                  // mov al, [y]
+                    emit(0x88); mem(0, X);                  // mov [x], al
+                    break;
+                case SET_OR_XY:
+                case SET_AND_XY:
+                case SET_XOR_XY:
+                    emit(0x8A); mem(0, Y);                  // mov al, [y]
+                    emit(instr.op == SET_OR_XY ? 0x08       // or [x], al
+                         : instr.op == SET_AND_XY ? 0x20    // and [x], al
+                         : 0x30);                           // xor [x], al
+                    mem(0, X);
+                    if (Quirks::logicResetsVF)
+                    {
+                        emit(0xC6); mem(0, VF); emit(0x00); // mov [vf], 0
+                    }
+                    break;
+                case ADD_CARRY_XY:
+                    emit(0x8A); mem(0, X);                  // mov al, [x]
+                    emit(0x02); mem(0, Y);                  // add al, [y]
+                    emit(0x0F); emit(0x92); emit(0xC1);     // setc cl
+                    emit(0x88); mem(1, VF);                 // mov [vf], cl
+                    emit(0x88); mem(0, X);                  // mov [x], al
+                    break;
+                case SUB_BORROW_XY:
+                case SUB_BORROW_YX:
+                {
+                    // tmp = a - b; VF = tmp < a; VX = tmp
+                    unsigned a = instr.op == SUB_BORROW_XY ? X : Y;
+                    unsigned b = instr.op == SUB_BORROW_XY ? Y : X;
+                    emit(0x8A); mem(0, a);                  // mov al, [a]
+                    emit(0x88); emit(0xC2);                 // mov dl, al
+                    emit(0x2A); mem(0, b);                  // sub al, [b]
+                    emit(0x38); emit(0xD0);                 // cmp al, dl
+                    emit(0x0F); emit(0x92); emit(0xC1);     // setb cl
+                    emit(0x88); mem(1, VF);                 // mov [vf], cl
+                    emit(0x88); mem(0, X);                  // mov [x], al
+                    break;
+                }
+                case SHIFT_RIGHT_X:
+                    if (Quirks::shiftsVY)
+                    {
+                        emit(0x8A); mem(0, Y);              // mov al, [y]
+                        emit(0x88); emit(0xC2);             // mov dl, al
+                        emit(0x24); emit(0x01);             // and al, 1
+                        emit(0x88); mem(0, VF);             // mov [vf], al
+                        emit(0xD0); emit(0xEA);             // shr dl, 1
+                        emit(0x88); mem(2, X);              // mov [x], dl
+                        break;
+                    }
+                    emit(0x8A); mem(0, X);                  // mov al, [x]
+                    emit(0x24); emit(0x01);                 // and al, 1
+                    emit(0x88); mem(0, VF);                 // mov [vf], al
+                    emit(0xD0); mem(5, X);                  // shr [x], 1
+                    break;
+                case SHIFT_LEFT_X:
+                    if (Quirks::shiftsVY)
+                    {
+                        emit(0x8A); mem(0, Y);              // mov al, [y]
+                        emit(0x88); emit(0xC2);             // mov dl, al
+                        emit(0xC0); emit(0xE8); emit(0x07); // shr al, 7
+                        emit(0x88); mem(0, VF);             // mov [vf], al
+                        emit(0xD0); emit(0xE2);             // shl dl, 1
+                        emit(0x88); mem(2, X);              // mov [x], dl
+                        break;
+                    }
+                    emit(0x8A); mem(0, X);                  // mov al, [x]
+                    emit(0xC0); emit(0xE8); emit(0x07);     // shr al, 7
+                    emit(0x88); mem(0, VF);                 // mov [vf], al
+                    emit(0xD0); mem(4, X);                  // shl [x], 1
+                    break;
+                case SET_INN:
+                    emit(0x66); emit(0xC7); mem(0, I_);     // mov [i], nnn
+                    emit16(instr.nnn);
+                    break;
+                case ADD_IX:
+                    emit(0x0F); emit(0xB6); mem(0, X);      // movzx eax, [x]
+                    emit(0x66); emit(0x01); mem(0, I_);     // add [i], ax
+                    if (!Quirks::addIndexSetsVF)
+                        break;
+                    emit(0x66); emit(0x81); mem(7, I_);     // cmp [i], 0xFFF
+                    emit16(0x0FFF);
+                    emit(0x0F); emit(0x97); emit(0xC1);     // seta cl
+                    emit(0x88); mem(1, VF);                 // mov [vf], cl
+                    break;
+                case SET_I_LONG:
+                    emit(0x66); emit(0xC7); mem(0, I_);     // mov [i], nnnn
+                    emit16((machine.memory_[next] << 8)
+                           | machine.memory_[next + 1]);
+                    next += 2;
+                    break;
+                case SET_I_SPRITE:
+                    emit(0x0F); emit(0xB6); mem(0, X);      // movzx eax, [x]
+                    emit(0x8D); emit(0x04); emit(0x80);     // lea eax, [rax+rax*4]
+                    emit(0x66); emit(0x89); mem(0, I_);     // mov [i], ax
+                    break;
+                case SET_XTIMER:
+                    emit(0x8A); mem(0, delay_);             // mov al, [delay]
+                    emit(0x88); mem(0, X);                  // mov [x], al
+                    break;
+                case SET_TIMERX:
+                case SET_SOUNDX:
+                    emit(0x8A); mem(0, X);                  // mov al, [x]
+                    emit(0x88);                             // mov [timer], al
+                    mem(0, instr.op == SET_TIMERX ? delay_ : sound_);
+                    break;
+                case JUMP:
+                    exit(instr.nnn);
+                    open = false;
+                    break;
+                case SKIPS_EQ_XNN:
+                case SKIPS_NEQ_XNN:
+                case SKIPS_EQ_XY:
+                case SKIPS_NEQ_XY:
+                {
+                    // Leave with pc_ past the next instruction, unless the
+                    // condition fails. The block covers the first word of
+                    // that instruction, which tells its length
+                    unsigned skipped = next + 2;
+                    if (machine.memory_[next] == 0xF0
+                        && machine.memory_[next + 1] == 0x00)
+                        skipped += 2;
+                    end = next + 2;
+
+                    emit(0x66); emit(0xC7); mem(0, pc_);    // mov [pc], next
+                    emit16(next & 0x0FFF);
+                    if (instr.op == SKIPS_EQ_XNN || instr.op == SKIPS_NEQ_XNN)
+                    {
+                        emit(0x80); mem(7, X);              // cmp [x], nn
+                        emit(instr.nn);
+                    }
+                    else
+                    {
+                        emit(0x8A); mem(0, Y);              // mov al, [y]
+                        emit(0x38); mem(0, X);              // cmp [x], al
+                    }
+                    emit(instr.op == SKIPS_EQ_XNN || instr.op == SKIPS_EQ_XY
+                         ? 0x75                             // jne
+                         : 0x74);                           // je
+                    emit(0x0A);
+                    exit(skipped);
+                    emit(0xC3);                             // ret
+                    open = false;
+                    break;
+                }
+                default:
+                    // Interpreted: the block stops right before it
+                    open = false;
+                    next = address;
+                    if (block.length > 0)
+                        exit(address);
+                    break;
+            }
+
+            if (next != address)
+            {
+                address = next;
+                ++block.length;
+            }
+        }
+
+        // Ran out of room for more instructions
+        if (open && block.length > 0)
+            exit(address);
+
+        // Empty blocks, to interpret, are listed too, so that writing a
+        // compilable instruction at pc gets them retried
+        if (block.length == 0)
+            used_ = start;
+        else
+            block.code = reinterpret_cast<Code>(code_ + start);
+        block.end = std::max(std::max(address, end), pc + 2);
+        if (block.end > MEMORY)
+            block.end = MEMORY;
+        for (unsigned page = pc / PAGE; page <= (block.end - 1) / PAGE; ++page)
+            pages_[page].push_back(pc);
+    }
+# endif
+}
+
+#endif /* !JIT_HH_ */
@@ -1,73 +1,289 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
 #include "chip8.hh"
+#include "frontend.hh"
+#include "input.hh"
+#include "movie.hh"
+#include "rewind.hh"
+#include "scheduler.hh"
+#include "triple_buffer.hh"
 
-#define WIDTH 64
-#define HEIGHT 32
+
+namespace
+{
+    // Build with -DCHIP8_PROFILE for a report of the hottest instructions
+    // on exit
+#ifdef CHIP8_PROFILE
+    typedef chip8::Profile Instrument;
+#else
+    typedef chip8::NoProfile Instrument;
+#endif
+
+    // Build with -DCHIP8_QUIRKS=chip8::SChipQuirks, for instance, for games
+    // relying on the behavior of another interpreter
+#ifdef CHIP8_QUIRKS
+    typedef CHIP8_QUIRKS Quirks;
+#else
+    typedef chip8::DefaultQuirks Quirks;
+#endif
+
+
+    // Screen handed from the emulation thread to the UI thread
+    struct Frame
+    {
+        chip8::Screen   image;
+        std::uint64_t   rows = 0; // Bit y for row y, changed since the last
+
+        // As a machine, for Renderer::update()
+        const chip8::Screen& screen() const { return image; }
+    };
+
+
+    int usage(const char* name)
+    {
+        std::cerr << "usage: " << name << " ROM [options]\n"
+            "  --rate HZ     instructions per emulated second (default 600)\n"
+            "  --speed X     emulated time per real time (default 1)\n"
+            "  --uncapped    run as fast as possible\n"
+            "  --scale N     window pixels per Chip8 pixel (default 10)\n"
+            "  --fg RRGGBB   color of lit pixels (default ffffff)\n"
+            "  --bg RRGGBB   color of unlit pixels (default 000000)\n"
+            "  --fg2 RRGGBB  color of pixels lit on the second XO-CHIP plane\n"
+            "                (default ff6600)\n"
+            "  --fg3 RRGGBB  color of pixels lit on both planes (default 662200)\n"
+            "  --rewind MB   memory kept for rewinding with BackSpace (default 4)\n"
+            "  --record FILE record the session as a movie, for chip8-headless\n"
+            "  --mute        play no sound\n";
+        return 1;
+    }
+}
 
 int main(int argc, char *argv[])
 {
-    if (argc > 1)
+    const char* rom = nullptr;
+    unsigned    rate = 600;
+    double      speed = 1.0;
+    unsigned    scale = 10;
+    sf::Color   foreground = sf::Color::White;
+    sf::Color   background = sf::Color::Black;
+    sf::Color   second(0xFF, 0x66, 0x00);
+    sf::Color   both(0x66, 0x22, 0x00);
+    std::size_t history = 4;
+    const char* record = nullptr;
+    bool        mute = false;
+
+    for (int i = 1; i < argc; ++i)
     {
-        chip8::Chip8<unsigned char, unsigned short> chip8;
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--rate") == 0 && hasValue)
+            rate = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--speed") == 0 && hasValue)
+            speed = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--uncapped") == 0)
+            speed = 0;
+        else if (std::strcmp(argv[i], "--scale") == 0 && hasValue)
+            scale = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--fg") == 0 && hasValue)
+            foreground = chip8::parseColor(argv[++i]);
+        else if (std::strcmp(argv[i], "--bg") == 0 && hasValue)
+            background = chip8::parseColor(argv[++i]);
+        else if (std::strcmp(argv[i], "--fg2") == 0 && hasValue)
+            second = chip8::parseColor(argv[++i]);
+        else if (std::strcmp(argv[i], "--fg3") == 0 && hasValue)
+            both = chip8::parseColor(argv[++i]);
+        else if (std::strcmp(argv[i], "--rewind") == 0 && hasValue)
+            history = std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--record") == 0 && hasValue)
+            record = argv[++i];
+        else if (std::strcmp(argv[i], "--mute") == 0)
+            mute = true;
+        else if (argv[i][0] != '-' && rom == nullptr)
+            rom = argv[i];
+        else
+            return usage(argv[0]);
+    }
+
+    if (rom != nullptr && scale > 0)
+    {
+        typedef chip8::Chip8<unsigned char, unsigned short,
+                             chip8::SwitchCore, Instrument, Quirks> Machine;
+        Machine chip8;
+        chip8::Rewind<Machine> rewind(history << 20);
 
         // Graphics
-        sf::RenderWindow window(sf::VideoMode(WIDTH, HEIGHT), "Chip8 Emulator");
+        sf::RenderWindow window(sf::VideoMode(chip8::Renderer::WIDTH * scale,
+                                              chip8::Renderer::HEIGHT * scale),
+                                "Chip8 Emulator");
+        // Only the UI thread waits for the display
+        window.setVerticalSyncEnabled(true);
+        chip8::Renderer renderer(scale, foreground, background, second, both);
+
+        // Sound, rendered as emulated time passes
+        chip8::Audio audio;
+        chip8::AudioOutput output(audio);
 
         // init
-        chip8.initialize();
-        chip8.loadGame(argv[1]);
+        std::uint64_t seed = time(NULL);
+        chip8::Movie movie(seed);
+
+        chip8.initialize(seed);
+        if (!chip8.loadGame(rom))
+        {
+            std::cerr << "Invalid ROM: " << rom << std::endl;
+            return 1;
+        }
 
         std::cerr << "Running game..." << std::endl;
+        if (!mute)
+            output.play();
+
+        // Emulation, on its own thread so that presenting never holds it
+        // back. The UI thread shows the latest frame it published, and
+        // forwards key events and BackSpace to it
+        std::atomic<bool>           running(true);
+        std::atomic<bool>           rewinding(false);
+        chip8::InputQueue           input;
+        chip8::TripleBuffer<Frame>  frames;
+
+        std::thread emulation([&]()
+        {
+            chip8::Scheduler    scheduler(rate, speed);
+            std::uint64_t       unread = 0; // Rows of frames maybe not shown
+
+            while (running.load(std::memory_order_relaxed))
+            {
+                // One frame of emulated time, or back in time while
+                // BackSpace is held
+                if (history > 0 && rewinding.load(std::memory_order_relaxed))
+                {
+                    if (rewind.rewind(chip8, 1) > 0 && record != nullptr)
+                        movie.truncate(chip8.cycles());
+                }
+                else
+                {
+                    chip8::runWithInput(chip8, input,
+                                        scheduler.cyclesForFrame(),
+                                        record != nullptr ? &movie : nullptr);
+                    if (!mute)
+                        audio.tick(chip8);
+                    chip8.updateTimers();
+                    if (record != nullptr)
+                        movie.record(chip8.cycles(), chip8::Movie::TICK);
+                    if (history > 0)
+                        rewind.record(chip8);
+                }
 
-        // Emulation loop
-        sf::Clock   clock;
-        unsigned    nbCyclesPerSec = 10;
-        unsigned    nbCycles = 0;
+                // Publish the screen, along with the rows changed since the
+                // last frame the UI thread took
+                std::uint64_t rows;
+                if (scheduler.presentDue() && (rows = chip8.dirtyRows()) != 0)
+                {
+                    Frame& frame = frames.back();
+
+                    frame.image = chip8.screen();
+                    frame.rows = rows | unread;
+                    chip8.markPresented();
+                    // Once the frame it replaced was read, only this one
+                    // may be missed
+                    unread = frames.publish() ? rows : rows | unread;
+                }
+
+                scheduler.waitFrame();
+            }
+        });
 
         // Running emulator
-        while (window.isOpen())
+        std::uint32_t held = 0; // Bit k for key k, as sent to input
+        std::uint32_t releasing = 0; // Held, the release not queued yet
+        // Release key from input, or retry later when it is full
+        auto release = [&](unsigned key)
         {
-            if (nbCycles < nbCyclesPerSec)
+            if (input.release(key))
             {
-                chip8.cycle();
-                ++nbCycles;
+                held &= ~(1u << key);
+                releasing &= ~(1u << key);
             }
+            else
+                releasing |= 1u << key;
+        };
 
-            if (clock.getElapsedTime().asMilliseconds() >= 1000 / 60)
+        while (window.isOpen())
+        {
+            if (frames.update())
             {
-                // Update timers
-                chip8.updateTimers();
-                nbCycles = 0;
+                renderer.update(frames.front(), frames.front().rows);
+                renderer.draw(window);
+                window.display();
+            }
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-                // Update screen
-                if (chip8.getDrawFlag())
-                {
-                    window.clear();
-                    chip8.draw(window);
-                    window.display();
-                    chip8.setDrawFlag(false);
-                }
+            rewinding.store(window.hasFocus()
+                    && sf::Keyboard::isKeyPressed(sf::Keyboard::BackSpace),
+                    std::memory_order_relaxed);
 
-                // Deal with events
-                sf::Event event;
-                while (window.pollEvent(event))
+            for (std::uint32_t keys = releasing; keys != 0; keys &= keys - 1)
+                release(chip8::lowestBit(keys));
+
+            // Deal with events
+            sf::Event event;
+            while (window.pollEvent(event))
+            {
+                switch (event.type)
                 {
-                    switch (event.type)
+                    case sf::Event::Closed:
+                        window.close();
+                        break;
+                    case sf::Event::KeyPressed:
                     {
-                        case sf::Event::Closed:
-                            window.close();
-                            break;
-                        case sf::Event::KeyPressed:
-                            chip8.setKey();
-                            break;
-                        default:
-                            break;
-                    };
-                }
+                        unsigned key = chip8::keyOf(event.key.code);
 
-                // Restart clock
-                clock.restart();
+                        // Pressed again before its release was queued,
+                        // it simply stays held
+                        if (key < 16 && (releasing & (1u << key)))
+                            releasing &= ~(1u << key);
+                        // Ignoring auto repeat
+                        else if (key < 16 && !(held & (1u << key))
+                                 && input.press(key))
+                            held |= 1u << key;
+                        break;
+                    }
+                    case sf::Event::KeyReleased:
+                    {
+                        unsigned key = chip8::keyOf(event.key.code);
+
+                        if (key < 16 && (held & (1u << key)))
+                            release(key);
+                        break;
+                    }
+                    case sf::Event::LostFocus:
+                        // Releases would go to another window
+                        for (std::uint32_t keys = held; keys != 0;
+                             keys &= keys - 1)
+                            release(chip8::lowestBit(keys));
+                        break;
+                    default:
+                        break;
+                };
             }
         }
+
+        running.store(false, std::memory_order_relaxed);
+        emulation.join();
+
+        chip8.instrument().report(std::cerr);
+        if (record != nullptr && !movie.save(record))
+        {
+            std::cerr << "Cannot save movie: " << record << std::endl;
+            return 1;
+        }
     }
+    else
+        return usage(argv[0]);
     return 0;
 }
@@ -0,0 +1,74 @@
+#ifndef MAPPED_FILE_HH_
+# define MAPPED_FILE_HH_
+
+# include <cstddef>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+
+namespace chip8
+{
+    /// @class MappedFile
+    /// @brief Read-only memory mapping of a whole file
+    class MappedFile
+    {
+        public:
+            MappedFile() : data_(nullptr), size_(0) {}
+            ~MappedFile() { close(); }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            bool open(const char* path);
+            void close();
+
+            const unsigned char* data() const { return data_; }
+            std::size_t size() const { return size_; }
+
+        private:
+            const unsigned char*    data_;
+            std::size_t             size_;
+    };
+
+
+    inline bool MappedFile::open(const char* path)
+    {
+        struct stat st;
+        int         fd;
+        bool        ok;
+
+        close();
+        if ((fd = ::open(path, O_RDONLY)) < 0)
+            return false;
+
+        // An empty file maps to nothing, but is still valid
+        ok = fstat(fd, &st) == 0;
+        if (ok && st.st_size > 0)
+        {
+            void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE,
+                              fd, 0);
+
+            ok = data != MAP_FAILED;
+            if (ok)
+            {
+                data_ = static_cast<const unsigned char*>(data);
+                size_ = st.st_size;
+            }
+        }
+
+        ::close(fd);
+        return ok;
+    }
+
+
+    inline void MappedFile::close()
+    {
+        if (data_ != nullptr)
+            munmap(const_cast<unsigned char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+#endif /* !MAPPED_FILE_HH_ */
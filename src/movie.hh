@@ -0,0 +1,146 @@
+#ifndef MOVIE_HH_
+# define MOVIE_HH_
+
+# include <cstdint>
+# include <cstring>
+# include <fstream>
+# include <vector>
+# include "mapped_file.hh"
+
+namespace chip8
+{
+    // Movies start with this magic and version, followed by the seed in
+    // host byte order
+    static const char           MOVIE_MAGIC[4] = { 'C', '8', 'M', 'V' };
+    static const std::uint32_t  MOVIE_VERSION = 2;
+
+    /// @class Movie
+    /// @brief Inputs of a session started by initialize(seed) and
+    /// loadGame(), each stamped with the cycles() of the machine when it
+    /// happened, so that replaying them gives back the very same session.
+    ///
+    /// Events are saved as the cycles elapsed since the previous one, an
+    /// unsigned LEB128 varint, followed by the event code
+    class Movie
+    {
+        public:
+            // Event codes
+            static const std::uint8_t   PRESS = 0x10; // Or'ed with the key
+            static const std::uint8_t   TICK = 0x20; // updateTimers()
+            static const std::uint8_t   RELEASE = 0x30; // Or'ed with the key
+
+            struct Event
+            {
+                std::uint64_t   cycle;
+                std::uint8_t    code;
+            };
+
+            explicit Movie(std::uint64_t seed = 0) : seed_(seed) {}
+
+            // Append an event, cycle never going backwards
+            void record(std::uint64_t cycle, std::uint8_t code);
+            // Forget the events that happened after the timer tick at cycle,
+            // e.g. when the machine is rewound to the state it had then
+            void truncate(std::uint64_t cycle);
+
+            bool save(const char* path) const;
+            bool load(const char* path);
+
+            std::uint64_t seed() const { return seed_; }
+            const std::vector<Event>& events() const { return events_; }
+
+        private:
+            std::uint64_t       seed_;
+            std::vector<Event>  events_;
+    };
+
+
+    inline void Movie::record(std::uint64_t cycle, std::uint8_t code)
+    {
+        Event event = { cycle, code };
+        events_.push_back(event);
+    }
+
+
+    inline void Movie::truncate(std::uint64_t cycle)
+    {
+        while (!events_.empty()
+               && (events_.back().cycle > cycle
+                   || (events_.back().cycle == cycle
+                       && events_.back().code != TICK)))
+            events_.pop_back();
+    }
+
+
+    inline bool Movie::save(const char* path) const
+    {
+        std::ofstream   ofs(path, std::ofstream::out | std::ofstream::binary);
+        std::uint64_t   last = 0;
+
+        ofs.write(MOVIE_MAGIC, sizeof (MOVIE_MAGIC));
+        ofs.write(reinterpret_cast<const char*>(&MOVIE_VERSION),
+                  sizeof (MOVIE_VERSION));
+        ofs.write(reinterpret_cast<const char*>(&seed_), sizeof (seed_));
+
+        for (const Event& event : events_)
+        {
+            std::uint64_t delta = event.cycle - last;
+
+            for (; delta >= 0x80; delta >>= 7)
+                ofs.put(static_cast<char>((delta & 0x7F) | 0x80));
+            ofs.put(static_cast<char>(delta));
+            ofs.put(static_cast<char>(event.code));
+            last = event.cycle;
+        }
+
+        return ofs.good();
+    }
+
+
+    inline bool Movie::load(const char* path)
+    {
+        MappedFile      file;
+        std::uint32_t   version;
+        std::uint64_t   cycle = 0;
+        std::size_t     header = sizeof (MOVIE_MAGIC) + sizeof (version)
+            + sizeof (seed_);
+
+        if (!file.open(path) || file.size() < header
+            || std::memcmp(file.data(), MOVIE_MAGIC, sizeof (MOVIE_MAGIC)) != 0)
+            return false;
+
+        std::memcpy(&version, file.data() + sizeof (MOVIE_MAGIC),
+                    sizeof (version));
+        if (version != MOVIE_VERSION)
+            return false;
+        std::memcpy(&seed_, file.data() + sizeof (MOVIE_MAGIC)
+                    + sizeof (version), sizeof (seed_));
+
+        events_.clear();
+        for (std::size_t i = header; i < file.size(); )
+        {
+            std::uint64_t delta = 0;
+            unsigned      shift = 0;
+
+            // At most 10 bytes, of which only bit 0 of the 10th fits in
+            // 64 bits, the rest being dropped by the shift
+            for (; i < file.size() && (file.data()[i] & 0x80); ++i, shift += 7)
+            {
+                if (shift >= 64)
+                    return false;
+                delta |= std::uint64_t(file.data()[i] & 0x7F) << shift;
+            }
+            // Last byte of the delta, then the code
+            if (i + 1 >= file.size() || shift >= 64)
+                return false;
+            delta |= std::uint64_t(file.data()[i]) << shift;
+            cycle += delta;
+            record(cycle, file.data()[i + 1]);
+            i += 2;
+        }
+
+        return true;
+    }
+}
+
+#endif /* !MOVIE_HH_ */
@@ -13,16 +13,30 @@ namespace chip8
         CALL,
         CLEAR,
         DRAW,
+        EXIT,
         FILLS_0X,
+        FILLS_FLAGS_0X,
+        FILLS_XY,
+        HIGH_RES,
         JUMP,
         JUMP_0NNN,
         KEY_AWAIT,
+        LOW_RES,
         RAND,
         RETURNS,
+        SCROLL_DOWN,
+        SCROLL_LEFT,
+        SCROLL_RIGHT,
+        SCROLL_UP,
         SET_AND_XY,
         SET_INN,
+        SET_I_BIG_SPRITE,
+        SET_I_LONG,
         SET_I_SPRITE,
         SET_OR_XY,
+        SET_PATTERN,
+        SET_PITCHX,
+        SET_PLANE,
         SET_SOUNDX,
         SET_TIMERX,
         SET_XNN,
@@ -39,131 +53,55 @@ namespace chip8
         SKIPS_PRESS,
         STORE_0X,
         STORE_BINARY,
+        STORE_FLAGS_0X,
+        STORE_XY,
         SUB_BORROW_XY,
         SUB_BORROW_YX,
         UNKNOWN
     };
 
-# ifdef DEBUG
-    template <typename Word>
-    void prettyPrint(Opcode opcode, Word value)
+    // Every Opcode, in the order of the enum
+# define CHIP8_OPCODES(X)                                               \
+    X(ADD_CARRY_XY) X(ADD_IX) X(ADD_XNN) X(CALL) X(CLEAR) X(DRAW)       \
+    X(EXIT) X(FILLS_0X) X(FILLS_FLAGS_0X) X(FILLS_XY) X(HIGH_RES)       \
+    X(JUMP) X(JUMP_0NNN) X(KEY_AWAIT) X(LOW_RES) X(RAND) X(RETURNS)     \
+    X(SCROLL_DOWN) X(SCROLL_LEFT) X(SCROLL_RIGHT) X(SCROLL_UP)          \
+    X(SET_AND_XY) X(SET_INN) X(SET_I_BIG_SPRITE) X(SET_I_LONG)          \
+    X(SET_I_SPRITE) X(SET_OR_XY) X(SET_PATTERN) X(SET_PITCHX)           \
+    X(SET_PLANE) X(SET_SOUNDX) X(SET_TIMERX) X(SET_XNN) X(SET_XOR_XY)   \
+    X(SET_XTIMER) X(SET_XY) X(SHIFT_LEFT_X) X(SHIFT_RIGHT_X)            \
+    X(SKIPS_EQ_XNN) X(SKIPS_EQ_XY) X(SKIPS_NEQ_XNN) X(SKIPS_NEQ_XY)     \
+    X(SKIPS_NPRESS) X(SKIPS_PRESS) X(STORE_0X) X(STORE_BINARY)          \
+    X(STORE_FLAGS_0X) X(STORE_XY) X(SUB_BORROW_XY) X(SUB_BORROW_YX)     \
+    X(UNKNOWN)
+
+    /// @struct Instruction
+    /// @brief Pre-decoded opcode, with its operands already extracted
+    template <typename Byte, typename Word>
+    struct Instruction
     {
-        std::cerr << "\033[32m" << std::hex << value << "\033[37m ";
-        switch (opcode)
-        {
-            case CLEAR:
-                debug("Clear");
-                break;
-            case RETURNS:
-                debug("Returns");
-                break;
-            case JUMP:
-                debug("Jumps");
-                break;
-            case CALL:
-                debug("Calls");
-                break;
-            case SKIPS_EQ_XNN:
-                debug("Skip_eq_xnn");
-                break;
-            case SKIPS_NEQ_XNN:
-                debug("Skip_neq_xnn");
-                break;
-            case SKIPS_EQ_XY:
-                debug("Skip_eq_xy");
-                break;
-            case SKIPS_NEQ_XY:
-                debug("Skip_neq_xy");
-                break;
-            case SET_XNN:
-                debug("Set_xnn");
-                break;
-            case ADD_XNN:
-                debug("Add_xnn");
-                break;
-            case SET_XY:
-                debug("Set_xy");
-                break;
-            case SET_OR_XY:
-                debug("Set_or_xy");
-                break;
-            case SET_AND_XY:
-                debug("Set_and_xy");
-                break;
-            case SET_XOR_XY:
-                debug("Set_xor_xy");
-                break;
-            case ADD_CARRY_XY:
-                debug("Add_carry_xy");
-                break;
-            case SUB_BORROW_XY:
-                debug("Sub_borrow_xy");
-                break;
-            case SHIFT_RIGHT_X:
-                debug("Shift_right_x");
-                break;
-            case SHIFT_LEFT_X:
-                debug("Shift_left_x");
-                break;
-            case SUB_BORROW_YX:
-                debug("Sub_borrow_yx");
-                break;
-            case SET_INN:
-                debug("Set_inn");
-                break;
-            case JUMP_0NNN:
-                debug("Jump_0NNN");
-                break;
-            case RAND:
-                debug("Rand");
-                break;
-            case DRAW:
-                debug("Draw");
-                break;
-            case SKIPS_PRESS:
-                debug("Skips_press");
-                break;
-            case SKIPS_NPRESS:
-                debug("Skips_npress");
-                break;
-            case SET_XTIMER:
-                debug("Set_xTimer");
-                break;
-            case KEY_AWAIT:
-                debug("Key_wait");
-                break;
-            case SET_TIMERX:
-                debug("Set_Timerx");
-                break;
-            case SET_SOUNDX:
-                debug("Set_Soundx");
-                break;
-            case ADD_IX:
-                debug("Add_Ix");
-                break;
-            case SET_I_SPRITE:
-                debug("Set_I_Sprite");
-                break;
-            case STORE_BINARY:
-                debug("Store_Binary");
-                break;
-            case STORE_0X:
-                debug("Store_0x");
-                break;
-            case FILLS_0X:
-                debug("Fills_0X");
-                break;
-            case UNKNOWN:
-                debug("Unknown");
-                break;
-        };
-    }
-# else
-    template <typename Word>
-    void prettyPrint(Opcode, Word)
+        // Value of op for a slot that has not been decoded yet
+        static const Byte UNDECODED = 0xFF;
+
+        Byte    op;     // Opcode
+        Byte    x;      // _X__
+        Byte    y;      // __Y_
+        Byte    nn;     // __NN
+        Word    nnn;    // _NNN
+        Word    opcode; // Raw 16-bits opcode
+    };
+
+    // Name of an Opcode, as spelled in the enum
+    inline const char* opcodeName(Opcode opcode)
     {
+# define CHIP8_NAME(op) #op,
+        static const char* const names[] = { CHIP8_OPCODES(CHIP8_NAME) };
+        static_assert(sizeof (names) / sizeof (*names) == UNKNOWN + 1,
+                      "names must cover every Opcode");
+# undef CHIP8_NAME
+
+        return opcode <= UNKNOWN ? names[opcode] : "?";
     }
-# endif
 
     template <typename Word>
     Opcode getOpcode(Word opcode)
@@ -183,7 +121,33 @@ namespace chip8
                         // 00EE - Returns from a subroutine
                         res = RETURNS;
                         break;
+                    case 0x00FB:
+                        // 00FB - Scrolls the screen right by 4 pixels
+                        res = SCROLL_RIGHT;
+                        break;
+                    case 0x00FC:
+                        // 00FC - Scrolls the screen left by 4 pixels
+                        res = SCROLL_LEFT;
+                        break;
+                    case 0x00FD:
+                        // 00FD - Exits the interpreter
+                        res = EXIT;
+                        break;
+                    case 0x00FE:
+                        // 00FE - Switches to the 64x32 low resolution
+                        res = LOW_RES;
+                        break;
+                    case 0x00FF:
+                        // 00FF - Switches to the 128x64 high resolution
+                        res = HIGH_RES;
+                        break;
                     default:
+                        // 00CN - Scrolls the screen down by N rows
+                        if ((opcode & 0xFFF0) == 0x00C0)
+                            res = SCROLL_DOWN;
+                        // 00DN - Scrolls the screen up by N rows
+                        else if ((opcode & 0xFFF0) == 0x00D0)
+                            res = SCROLL_UP;
                         // 0NNN - Calls RCA 1802 program at address NNN
                         break;
                 };
@@ -205,8 +169,23 @@ namespace chip8
                 res = SKIPS_NEQ_XNN;
                 break;
             case 5:
-                // 5XY0 - Skips the next instruction if VX equals VY
-                res = SKIPS_EQ_XY;
+                switch (opcode & 0x000F)
+                {
+                    case 0:
+                        // 5XY0 - Skips the next instruction if VX equals VY
+                        res = SKIPS_EQ_XY;
+                        break;
+                    case 2:
+                        // 5XY2 - Stores VX to VY in memory starting at
+                        // address I
+                        res = STORE_XY;
+                        break;
+                    case 3:
+                        // 5XY3 - Fills VX to VY with values from memory
+                        // starting at address I
+                        res = FILLS_XY;
+                        break;
+                };
                 break;
             case 6:
                 // 6XNN - Sets VX to NN
@@ -255,7 +234,7 @@ namespace chip8
                         // there's a borrow, and 1 when there isn't
                         res = SUB_BORROW_YX;
                         break;
-                    case 15:
+                    case 14:
                         // 8XYE - Shifts VX left by one. VF is set to the value
                         // of the most significant bit of VX before the shift
                         res = SHIFT_LEFT_X;
@@ -309,6 +288,21 @@ namespace chip8
             case 15:
                 switch (opcode & 0x00FF)
                 {
+                    case 0x0000:
+                        // F000 NNNN - Sets I to the address NNNN
+                        if (opcode == 0xF000)
+                            res = SET_I_LONG;
+                        break;
+                    case 0x0001:
+                        // FN01 - Selects the planes N to draw on
+                        res = SET_PLANE;
+                        break;
+                    case 0x0002:
+                        // F002 - Loads the audio pattern from the 16 bytes
+                        // at address I
+                        if (opcode == 0xF002)
+                            res = SET_PATTERN;
+                        break;
                     case 0x0007:
                         // FX07 - Sets VX to the value of the delay timer
                         res = SET_XTIMER;
@@ -335,6 +329,11 @@ namespace chip8
                         // 4x5 font
                         res = SET_I_SPRITE;
                         break;
+                    case 0x0030:
+                        // FX30 - Sets I to the location of the 8x10 sprite
+                        // for the character in VX
+                        res = SET_I_BIG_SPRITE;
+                        break;
                     case 0x0033:
                         // FX33 - Stores the Binary-coded decimal representation of VX,
                         // with the most significant of three digits at the address in I,
@@ -344,6 +343,10 @@ namespace chip8
                         // tens digit at location I+1, and the ones digit at location I+2.)
                         res = STORE_BINARY;
                         break;
+                    case 0x003A:
+                        // FX3A - Sets the pitch of the audio pattern to VX
+                        res = SET_PITCHX;
+                        break;
                     case 0x0055:
                         // FX55 - Stores V0 to VX in memory starting at address I
                         res = STORE_0X;
@@ -352,6 +355,14 @@ namespace chip8
                         // FX65 - Fills V0 to VX with values from memory starting at address I
                         res = FILLS_0X;
                         break;
+                    case 0x0075:
+                        // FX75 - Stores V0 to VX in the RPL user flags
+                        res = STORE_FLAGS_0X;
+                        break;
+                    case 0x0085:
+                        // FX85 - Fills V0 to VX from the RPL user flags
+                        res = FILLS_FLAGS_0X;
+                        break;
                 };
                 break;
             default:
@@ -361,6 +372,21 @@ namespace chip8
 
         return res;
     }
+
+    template <typename Byte, typename Word>
+    Instruction<Byte, Word> predecode(Word opcode)
+    {
+        Instruction<Byte, Word> res;
+
+        res.op      = getOpcode(opcode);
+        res.x       = get<1>(opcode);
+        res.y       = get<2>(opcode);
+        res.nn      = opcode & 0x00FF;
+        res.nnn     = opcode & 0x0FFF;
+        res.opcode  = opcode;
+
+        return res;
+    }
 }
 
 #endif /* !OPCODES_HH_ */
@@ -0,0 +1,143 @@
+#ifndef PROFILE_HH_
+# define PROFILE_HH_
+
+# include <algorithm>
+# include <array>
+# include <cstdint>
+# include <iomanip>
+# include <ostream>
+# include <utility>
+# include <vector>
+# include "opcodes.hh"
+# include "utility.hh"
+
+namespace chip8
+{
+    /// @struct NoProfile
+    /// @brief Instrumentation policy of Chip8 recording nothing, so that
+    /// its hooks compile away
+    struct NoProfile
+    {
+        // Instrumented machines skip the JIT, which bypasses the hooks
+        static const bool enabled = false;
+
+        void instruction(unsigned, Opcode) {}
+        void call(unsigned) {}
+        template <typename Machine, typename Instr>
+        void retire(const Machine&, const Instr&) {}
+        void report(std::ostream&, unsigned = 20) const {}
+    };
+
+
+    /// @class Profile
+    /// @brief Instrumentation policy of Chip8 counting executed
+    /// instructions by Opcode and by address, and calls by target
+    class Profile
+    {
+        public:
+            static const bool enabled = true;
+
+            Profile() { reset(); }
+
+            // Instruction at pc executed as op
+            CHIP8_INLINE void instruction(unsigned pc, Opcode op)
+            {
+                ++opcodes_[op];
+                ++addresses_[pc & 0x0FFF];
+            }
+
+            // Subroutine at target called
+            CHIP8_INLINE void call(unsigned target)
+            {
+                ++calls_[target & 0x0FFF];
+            }
+
+            template <typename Machine, typename Instr>
+            void retire(const Machine&, const Instr&) {}
+
+            void reset();
+
+            std::uint64_t instructions() const;
+            const std::array<std::uint64_t, UNKNOWN + 1>& opcodes() const
+            {
+                return opcodes_;
+            }
+            const std::array<std::uint64_t, 4096>& addresses() const
+            {
+                return addresses_;
+            }
+            const std::array<std::uint64_t, 4096>& calls() const
+            {
+                return calls_;
+            }
+
+            // Write counts as "opcode NAME COUNT" lines for every Opcode
+            // executed, then the top hottest "pc ADDRESS COUNT" and
+            // "call ADDRESS COUNT" lines, most frequent first
+            void report(std::ostream& os, unsigned top = 20) const;
+
+        private:
+            std::array<std::uint64_t, UNKNOWN + 1>  opcodes_;
+            std::array<std::uint64_t, 4096>         addresses_;
+            std::array<std::uint64_t, 4096>         calls_;
+    };
+
+
+    inline void Profile::reset()
+    {
+        opcodes_.fill(0);
+        addresses_.fill(0);
+        calls_.fill(0);
+    }
+
+
+    inline std::uint64_t Profile::instructions() const
+    {
+        std::uint64_t total = 0;
+
+        for (auto count : opcodes_)
+            total += count;
+        return total;
+    }
+
+
+    inline void Profile::report(std::ostream& os, unsigned top) const
+    {
+        typedef std::pair<std::uint64_t, unsigned> Count;
+
+        // Non zero counts, most frequent first, ties by index
+        auto sorted = [](const std::uint64_t* counts, unsigned size)
+        {
+            std::vector<Count> result;
+
+            for (unsigned i = 0; i < size; ++i)
+                if (counts[i] != 0)
+                    result.push_back(Count(counts[i], i));
+            std::stable_sort(result.begin(), result.end(),
+                    [](const Count& a, const Count& b)
+                    {
+                        return a.first > b.first;
+                    });
+            return result;
+        };
+
+        os << "instructions " << instructions() << '\n';
+        for (const auto& count : sorted(opcodes_.data(), opcodes_.size()))
+            os << "opcode " << opcodeName(static_cast<Opcode>(count.second))
+                << ' ' << count.first << '\n';
+
+        auto addresses = sorted(addresses_.data(), addresses_.size());
+        auto calls = sorted(calls_.data(), calls_.size());
+
+        os << std::hex << std::setfill('0');
+        for (unsigned i = 0; i < addresses.size() && i < top; ++i)
+            os << "pc " << std::setw(3) << addresses[i].second << ' '
+                << std::dec << addresses[i].first << std::hex << '\n';
+        for (unsigned i = 0; i < calls.size() && i < top; ++i)
+            os << "call " << std::setw(3) << calls[i].second << ' '
+                << std::dec << calls[i].first << std::hex << '\n';
+        os << std::dec << std::setfill(' ');
+    }
+}
+
+#endif /* !PROFILE_HH_ */
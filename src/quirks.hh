@@ -0,0 +1,87 @@
+#ifndef QUIRKS_HH_
+# define QUIRKS_HH_
+
+namespace chip8
+{
+    /// @struct DefaultQuirks
+    /// @brief Quirks policy of Chip8, choosing among the behaviors the
+    /// interpreters of the past disagree on. Every choice is a compile time
+    /// constant, so that the branches on it fold away.
+    ///
+    /// This one is how this emulator always behaved
+    struct DefaultQuirks
+    {
+        // 8XY1, 8XY2 and 8XY3 set VF to 0
+        static const bool logicResetsVF = false;
+        // 8XY6 and 8XYE shift VY into VX, rather than VX in place
+        static const bool shiftsVY = false;
+        // FX55 and FX65 leave I past the last register accessed...
+        static const bool memoryIncrementsI = true;
+        // ...or, with this one, on it
+        static const bool memoryIncrementsByX = false;
+        // BNNN jumps to XNN plus VX, rather than NNN plus V0
+        static const bool jumpsVX = false;
+        // Sprites are cut at the edges of the screen rather than wrapped
+        static const bool clipsSprites = false;
+        // FX1E sets VF when I goes past 0xFFF
+        static const bool addIndexSetsVF = true;
+    };
+
+
+    /// @struct VipQuirks
+    /// @brief The original interpreter of the COSMAC VIP
+    struct VipQuirks
+    {
+        static const bool logicResetsVF = true;
+        static const bool shiftsVY = true;
+        static const bool memoryIncrementsI = true;
+        static const bool memoryIncrementsByX = false;
+        static const bool jumpsVX = false;
+        static const bool clipsSprites = true;
+        static const bool addIndexSetsVF = false;
+    };
+
+
+    /// @struct Chip48Quirks
+    /// @brief CHIP-48, on the HP-48 calculators
+    struct Chip48Quirks
+    {
+        static const bool logicResetsVF = false;
+        static const bool shiftsVY = false;
+        static const bool memoryIncrementsI = true;
+        static const bool memoryIncrementsByX = true;
+        static const bool jumpsVX = true;
+        static const bool clipsSprites = true;
+        static const bool addIndexSetsVF = false;
+    };
+
+
+    /// @struct SChipQuirks
+    /// @brief SUPER-CHIP 1.1, which games written for the HP-48 expect
+    struct SChipQuirks
+    {
+        static const bool logicResetsVF = false;
+        static const bool shiftsVY = false;
+        static const bool memoryIncrementsI = false;
+        static const bool memoryIncrementsByX = false;
+        static const bool jumpsVX = true;
+        static const bool clipsSprites = true;
+        static const bool addIndexSetsVF = false;
+    };
+
+
+    /// @struct ModernQuirks
+    /// @brief Octo and XO-CHIP, which most recent games target
+    struct ModernQuirks
+    {
+        static const bool logicResetsVF = false;
+        static const bool shiftsVY = true;
+        static const bool memoryIncrementsI = true;
+        static const bool memoryIncrementsByX = false;
+        static const bool jumpsVX = false;
+        static const bool clipsSprites = false;
+        static const bool addIndexSetsVF = false;
+    };
+}
+
+#endif /* !QUIRKS_HH_ */
@@ -0,0 +1,53 @@
+#ifndef RANDOM_HH_
+# define RANDOM_HH_
+
+# include <cstdint>
+
+namespace chip8
+{
+    /// @class Random
+    /// @brief Small, seedable xorshift64* generator, owned by each machine
+    /// so that runs are reproducible and need no shared state
+    class Random
+    {
+        public:
+            explicit Random(std::uint64_t seed = 0) { reseed(seed); }
+
+            // Restart the sequence from seed, any value being valid
+            void reseed(std::uint64_t seed);
+            // Next 32 random bits
+            std::uint32_t next();
+
+            // Whole generator state, for snapshots
+            std::uint64_t state() const { return state_; }
+            void setState(std::uint64_t state) { state_ = state ? state : 1; }
+
+        private:
+            std::uint64_t   state_;
+    };
+
+
+    inline void Random::reseed(std::uint64_t seed)
+    {
+        // splitmix64 spreads close seeds apart, and never yields 0 for the
+        // xorshift state in practice
+        std::uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        setState(z ^ (z >> 31));
+    }
+
+
+    inline std::uint32_t Random::next()
+    {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+
+        // High bits are the best ones
+        return (state_ * 0x2545F4914F6CDD1DULL) >> 32;
+    }
+}
+
+#endif /* !RANDOM_HH_ */
@@ -0,0 +1,246 @@
+#ifndef REWIND_HH_
+# define REWIND_HH_
+
+# include <cstdint>
+# include <cstring>
+# include <vector>
+# include "snapshot.hh"
+
+namespace chip8
+{
+    /// @class Rewind
+    /// @brief Frame history of a machine for stepping back in time, within
+    /// a fixed memory budget allocated up front.
+    ///
+    /// Each recorded frame adds an entry to a byte ring holding what the
+    /// previous frame looked like, as a backward delta made of the runs of
+    /// bytes that changed since. Only the ranges saveState() wrote are
+    /// compared, which, past the first frame, are the few memory pages
+    /// written in between plus the registers and screen. Stepping back N
+    /// frames applies the N newest entries, newest first, to the frame last
+    /// recorded, so no full copy is ever kept. Once the ring is full, the
+    /// oldest entries are dropped.
+    template <typename Machine>
+    class Rewind
+    {
+        public:
+            explicit Rewind(std::size_t capacity = 4 << 20,
+                            std::size_t maxFrames = 60 * 60);
+
+            // Record the current frame, once per updateTimers()
+            void record(Machine& machine);
+            // Step machine back up to n frames, returning how many it went
+            unsigned long rewind(Machine& machine, unsigned long n);
+            // Frames that can be stepped back
+            std::size_t frames() const { return count_; }
+            void clear();
+
+        private:
+            struct Entry
+            {
+                std::size_t     offset; // In ring_
+                std::size_t     size;
+            };
+
+            // Encode current_ -> next_ as a delta into delta_, returning
+            // its size
+            std::size_t encode();
+            // Append the run "offset, length, old bytes" of current_ to out
+            unsigned char* run(unsigned char* out, std::size_t start,
+                               std::size_t end) const;
+            // Room for size bytes at head_, dropping the oldest entries
+            bool reserve(std::size_t size);
+
+            std::vector<unsigned char>  ring_;
+            std::vector<Entry>          entries_; // Ring of descriptors
+            std::size_t                 first_; // Oldest entry
+            std::size_t                 count_;
+            std::size_t                 head_; // Next free byte of ring_
+
+            Snapshot                    next_; // Frame being recorded
+            std::vector<unsigned char>  current_; // Frame last recorded
+            std::vector<unsigned char>  delta_;
+    };
+
+
+    template <typename Machine>
+    Rewind<Machine>::Rewind(std::size_t capacity, std::size_t maxFrames)
+        : ring_(capacity)
+        , entries_(maxFrames)
+    {
+        std::size_t size = Machine::stateSize();
+
+        next_.data.reserve(size);
+        current_.reserve(size);
+        // Worst case: every other byte changed, each run with its header
+        delta_.resize(size * 4);
+        clear();
+    }
+
+
+    template <typename Machine>
+    void Rewind<Machine>::clear()
+    {
+        first_ = 0;
+        count_ = 0;
+        head_ = 0;
+        current_.clear();
+    }
+
+
+    template <typename Machine>
+    unsigned char* Rewind<Machine>::run(unsigned char* out, std::size_t start,
+                                        std::size_t end) const
+    {
+        std::uint32_t offset = start;
+        std::uint32_t length = end - start;
+
+        std::memcpy(out, &offset, sizeof (offset));
+        std::memcpy(out + 4, &length, sizeof (length));
+        std::memcpy(out + 8, &current_[start], length);
+        return out + 8 + length;
+    }
+
+
+    template <typename Machine>
+    std::size_t Rewind<Machine>::encode()
+    {
+        const unsigned char*    before = current_.data();
+        const unsigned char*    after = next_.data.data();
+        unsigned char*          out = delta_.data();
+
+        // Runs of "offset, length, old bytes", merging runs separated by
+        // fewer bytes than a run header. Bytes the save did not write are
+        // the same as in current_
+        for (const Snapshot::Range& range : next_.written)
+            for (std::size_t i = range.begin; i < range.end; )
+            {
+                if (before[i] == after[i])
+                {
+                    ++i;
+                    continue;
+                }
+
+                std::size_t start = i;
+                std::size_t end = i + 1;
+                for (i = end; i < range.end && i - end < 8; ++i)
+                    if (before[i] != after[i])
+                        end = i + 1;
+                i = end;
+                out = run(out, start, end);
+            }
+
+        // Scattered changes cost more than a single run of everything
+        if (std::size_t(out - delta_.data()) > current_.size() + 8)
+            out = run(delta_.data(), 0, current_.size());
+        return out - delta_.data();
+    }
+
+
+    template <typename Machine>
+    bool Rewind<Machine>::reserve(std::size_t size)
+    {
+        if (size > ring_.size())
+            return false;
+
+        // Wrap around, dropping the entries left past head_: they are the
+        // oldest ones
+        if (head_ + size > ring_.size())
+        {
+            while (count_ > 0 && entries_[first_].offset >= head_)
+            {
+                first_ = (first_ + 1) % entries_.size();
+                --count_;
+            }
+            head_ = 0;
+        }
+
+        // Drop the oldest entries overlapping [head_, head_ + size)
+        while (count_ > 0)
+        {
+            const Entry& oldest = entries_[first_];
+
+            if (oldest.offset >= head_ + size
+                || oldest.offset + oldest.size <= head_)
+                break;
+            first_ = (first_ + 1) % entries_.size();
+            --count_;
+        }
+
+        // Out of descriptors
+        if (count_ == entries_.size())
+        {
+            first_ = (first_ + 1) % entries_.size();
+            --count_;
+        }
+
+        return true;
+    }
+
+
+    template <typename Machine>
+    void Rewind<Machine>::record(Machine& machine)
+    {
+        // Only the memory pages written since the last frame are copied
+        machine.saveState(next_);
+
+        if (current_.size() != next_.data.size())
+        {
+            current_ = next_.data;
+            return;
+        }
+
+        std::size_t size = encode();
+
+        if (!reserve(size))
+        {
+            clear();
+            current_ = next_.data;
+            return;
+        }
+
+        Entry& entry = entries_[(first_ + count_) % entries_.size()];
+        entry.offset = head_;
+        entry.size = size;
+        std::memcpy(&ring_[head_], delta_.data(), size);
+        head_ += size;
+        ++count_;
+
+        for (const Snapshot::Range& range : next_.written)
+            std::memcpy(&current_[range.begin], &next_.data[range.begin],
+                        range.end - range.begin);
+    }
+
+
+    template <typename Machine>
+    unsigned long Rewind<Machine>::rewind(Machine& machine, unsigned long n)
+    {
+        unsigned long steps = 0;
+
+        for (; steps < n && count_ > 0; ++steps)
+        {
+            const Entry& entry = entries_[(first_ + count_ - 1) % entries_.size()];
+            const unsigned char* data = &ring_[entry.offset];
+
+            for (const unsigned char* end = data + entry.size; data < end; )
+            {
+                std::uint32_t offset;
+                std::uint32_t length;
+
+                std::memcpy(&offset, data, sizeof (offset));
+                std::memcpy(&length, data + 4, sizeof (length));
+                std::memcpy(&current_[offset], data + 8, length);
+                data += 8 + length;
+            }
+
+            head_ = entry.offset;
+            --count_;
+        }
+
+        if (steps > 0)
+            machine.loadState(current_.data(), current_.size());
+        return steps;
+    }
+}
+
+#endif /* !REWIND_HH_ */
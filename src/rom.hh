@@ -0,0 +1,92 @@
+#ifndef ROM_HH_
+# define ROM_HH_
+
+# include <cstdint>
+# include <memory>
+# include <mutex>
+# include <string>
+# include <unordered_map>
+# include <vector>
+# include "mapped_file.hh"
+# include "utility.hh"
+
+namespace chip8
+{
+    // Memory, of 64 KiB as on XO-CHIP. Programs still run from the first
+    // 4 KiB, the rest being reachable through I only
+    static const std::size_t MEMORY_SIZE = 0x10000;
+    // Games are loaded at 0x200, up to the end of memory
+    static const std::size_t ROM_ADDRESS = 0x200;
+    static const std::size_t ROM_CAPACITY = MEMORY_SIZE - ROM_ADDRESS;
+
+    /// @struct RomImage
+    /// @brief Contents of a ROM file, with their hash
+    struct RomImage
+    {
+        std::vector<unsigned char>  data;
+        std::uint64_t               hash;
+    };
+
+
+    /// @class RomCache
+    /// @brief Read-only images of the ROMs loaded so far, keyed by path and
+    /// shared by content hash, so that many machines running the same game
+    /// load it from memory. Safe to use from several threads
+    class RomCache
+    {
+        public:
+            typedef std::shared_ptr<const RomImage> Image;
+
+            // Image of the ROM at path, read on first use. Null if it cannot
+            // be read or does not fit in memory
+            Image get(const std::string& path);
+
+            // Distinct images held
+            std::size_t size() const;
+
+        private:
+            mutable std::mutex                              mutex_;
+            std::unordered_map<std::string, Image>          paths_;
+            std::unordered_map<std::uint64_t, Image>        images_;
+    };
+
+
+    inline RomCache::Image RomCache::get(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto                        found = paths_.find(path);
+
+        if (found != paths_.end())
+            return found->second;
+
+        MappedFile file;
+
+        if (!file.open(path.c_str()) || file.size() > ROM_CAPACITY)
+            return Image();
+
+        std::shared_ptr<RomImage> image = std::make_shared<RomImage>();
+
+        image->data.assign(file.data(), file.data() + file.size());
+        image->hash = fnv1a(file.data(), file.size());
+
+        // The same game under another path shares its image, unless two
+        // different games collide on their hash
+        auto& shared = images_[image->hash];
+
+        if (shared == nullptr)
+            shared = image;
+        else if (shared->data == image->data)
+            return paths_[path] = shared;
+        return paths_[path] = image;
+    }
+
+
+    inline std::size_t RomCache::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        return images_.size();
+    }
+}
+
+#endif /* !ROM_HH_ */
@@ -0,0 +1,111 @@
+#ifndef SCHEDULER_HH_
+# define SCHEDULER_HH_
+
+# include <chrono>
+# include <thread>
+
+namespace chip8
+{
+    /// @class Scheduler
+    /// @brief Paces emulation in frames of 1/60 s of emulated time. Each
+    /// frame executes rate / 60 instructions and ends with one timer update,
+    /// so timers follow the emulated cycle count. Emulated time runs at
+    /// speed times real time, the host sleeping between frames, or as fast
+    /// as possible when speed is 0
+    class Scheduler
+    {
+        public:
+            typedef std::chrono::steady_clock Clock;
+
+            static const unsigned FRAME_RATE = 60;
+
+            explicit Scheduler(unsigned rate = 600, double speed = 1.0);
+
+            // Instructions to execute in the next frame, spreading
+            // rate / 60 remainders over successive frames
+            unsigned long cyclesForFrame();
+            // Sleep until the next frame is due
+            void waitFrame();
+            // Whether a frame should be shown, at most 60 times per second
+            // of real time
+            bool presentDue();
+
+            unsigned rate() const { return rate_; }
+            double speed() const { return speed_; }
+            void setSpeed(double speed);
+
+        private:
+            unsigned            rate_; // Instructions per emulated second
+            double              speed_; // Emulated time / real time, 0 uncapped
+            unsigned            remainder_;
+            Clock::duration     frame_; // Real duration of a frame
+            Clock::time_point   deadline_;
+            Clock::time_point   presented_;
+    };
+
+
+    inline Scheduler::Scheduler(unsigned rate, double speed)
+        : rate_(rate)
+        , remainder_(0)
+        , frame_(0)
+        , presented_()
+    {
+        setSpeed(speed);
+    }
+
+
+    inline unsigned long Scheduler::cyclesForFrame()
+    {
+        remainder_ += rate_;
+
+        unsigned long cycles = remainder_ / FRAME_RATE;
+        remainder_ %= FRAME_RATE;
+        return cycles;
+    }
+
+
+    inline void Scheduler::waitFrame()
+    {
+        if (speed_ <= 0)
+            return;
+
+        auto now = Clock::now();
+        deadline_ += frame_;
+
+        // Too far behind to catch up: drop the lost time instead of
+        // running a burst of frames
+        if (deadline_ + 4 * frame_ < now)
+            deadline_ = now;
+        else if (deadline_ > now)
+            std::this_thread::sleep_until(deadline_);
+    }
+
+
+    inline bool Scheduler::presentDue()
+    {
+        auto now = Clock::now();
+
+        // At most real time, every frame is shown
+        if (speed_ > 0 && speed_ <= 1)
+            return true;
+        if (now - presented_
+                < std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(1.0 / FRAME_RATE)))
+            return false;
+
+        presented_ = now;
+        return true;
+    }
+
+
+    inline void Scheduler::setSpeed(double speed)
+    {
+        speed_ = speed;
+        deadline_ = Clock::now();
+        if (speed_ > 0)
+            frame_ = std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(1.0 / (FRAME_RATE * speed_)));
+    }
+}
+
+#endif /* !SCHEDULER_HH_ */
@@ -0,0 +1,305 @@
+#ifndef SCREEN_HH_
+# define SCREEN_HH_
+
+# include <algorithm>
+# include <array>
+# include <cstdint>
+# include <cstring>
+
+namespace chip8
+{
+    /// @class Screen
+    /// @brief Framebuffer of the 128x64 pixels of SUPER-CHIP, with the two
+    /// bitplanes of XO-CHIP, one bit per pixel and plane: pixel (x, y) of
+    /// plane p is bit 63 - x % 64 of word 2 * p + x / 64 of row y, so that
+    /// its color is one of four. The low resolution mode of CHIP-8 only
+    /// uses the top left 64x32 pixels, so that each of its rows is a
+    /// single word per plane.
+    ///
+    /// Drawing, clearing and scrolling only affect the selected planes,
+    /// the first one unless told otherwise. Every method changing pixels
+    /// returns the rows it touched, bit y for row y, so that frontends only
+    /// convert those
+    class Screen
+    {
+        public:
+            static const unsigned   WIDTH = 128;
+            static const unsigned   HEIGHT = 64;
+            static const unsigned   PLANES = 2;
+
+            typedef std::array<std::uint64_t, 2 * PLANES>   Row;
+            typedef std::array<Row, HEIGHT>                 Rows;
+
+            Screen() : hires_(false), planes_(1) { rows_.fill(Row()); }
+
+            bool hires() const { return hires_; }
+            unsigned width() const { return hires_ ? WIDTH : WIDTH / 2; }
+            unsigned height() const { return hires_ ? HEIGHT : HEIGHT / 2; }
+            const Row& operator[](unsigned y) const { return rows_[y]; }
+            // Color of pixel (x, y), bit p for plane p
+            unsigned pixel(unsigned x, unsigned y) const;
+
+            // Selected planes, bit p for plane p
+            unsigned planes() const { return planes_; }
+            void setPlanes(unsigned planes) { planes_ = planes & 3; }
+
+            // Pixels, for saving and restoring states
+            const Rows& rows() const { return rows_; }
+            Rows& rows() { return rows_; }
+            void setHires(bool hires) { hires_ = hires; }
+
+            std::uint64_t clear();
+            // Switch resolution, clearing every plane
+            std::uint64_t resize(bool hires);
+
+            // XOR the sprite of the given lines at address in memory (of
+            // 64 KiB) onto (x, y), wrapped around the screen or clipped at
+            // its edges. Lines are 8 pixels wide, or 16 if wide. With both
+            // planes selected, the sprite of the second one follows that of
+            // the first. collision is set if any pixel was turned off
+            template <bool Clip, typename Byte>
+            std::uint64_t draw(const Byte* memory, unsigned address,
+                               unsigned x, unsigned y, unsigned lines,
+                               bool wide, bool& collision);
+
+            // Scroll n rows down or up, or 4 pixels right or left, bringing
+            // in blank pixels
+            std::uint64_t scrollDown(unsigned n);
+            std::uint64_t scrollUp(unsigned n);
+            std::uint64_t scrollRight();
+            std::uint64_t scrollLeft();
+
+        private:
+            // Draw onto the plane whose left words are at word, returning
+            // the rows touched and adding the pixels turned off to hit
+            template <bool Clip, typename Byte>
+            std::uint64_t drawPlane(unsigned word, const Byte* memory,
+                                    unsigned address, unsigned x, unsigned y,
+                                    unsigned lines, bool wide,
+                                    std::uint64_t& hit);
+            // Rows holding any pixel
+            std::uint64_t occupied() const;
+
+            Rows        rows_;
+            bool        hires_;
+            unsigned    planes_;
+    };
+
+
+    inline unsigned Screen::pixel(unsigned x, unsigned y) const
+    {
+        const Row&  row = rows_[y];
+        unsigned    shift = 63 - x % 64;
+
+        return ((row[x / 64] >> shift) & 1)
+            | (((row[2 + x / 64] >> shift) & 1) << 1);
+    }
+
+
+    inline std::uint64_t Screen::occupied() const
+    {
+        std::uint64_t rows = 0;
+
+        for (unsigned y = 0; y < HEIGHT; ++y)
+        {
+            const Row& row = rows_[y];
+            rows |= static_cast<std::uint64_t>(
+                    (row[0] | row[1] | row[2] | row[3]) != 0) << y;
+        }
+        return rows;
+    }
+
+
+    inline std::uint64_t Screen::clear()
+    {
+        std::uint64_t rows = occupied();
+
+        for (unsigned plane = 0; plane < PLANES; ++plane)
+            if (planes_ & (1 << plane))
+                for (Row& row : rows_)
+                    row[2 * plane] = row[2 * plane + 1] = 0;
+        return rows;
+    }
+
+
+    inline std::uint64_t Screen::resize(bool hires)
+    {
+        std::uint64_t rows = occupied();
+
+        hires_ = hires;
+        rows_.fill(Row());
+        return rows;
+    }
+
+
+    template <bool Clip, typename Byte>
+    std::uint64_t Screen::draw(const Byte* memory, unsigned address,
+                               unsigned x, unsigned y, unsigned lines,
+                               bool wide, bool& collision)
+    {
+        std::uint64_t   touched = 0;
+        std::uint64_t   hit = 0;
+
+        // Single plane drawing, as CHIP-8 and SUPER-CHIP only know, needs
+        // no loop
+        if (planes_ == 1)
+            touched = drawPlane<Clip>(0, memory, address, x, y, lines, wide,
+                                      hit);
+        else
+            for (unsigned plane = 0; plane < PLANES; ++plane)
+                if (planes_ & (1 << plane))
+                {
+                    touched |= drawPlane<Clip>(2 * plane, memory, address,
+                                               x, y, lines, wide, hit);
+                    address += wide ? 2 * lines : lines;
+                }
+
+        collision = hit != 0;
+        return touched;
+    }
+
+
+    template <bool Clip, typename Byte>
+    std::uint64_t Screen::drawPlane(unsigned word, const Byte* memory,
+                                    unsigned address, unsigned x, unsigned y,
+                                    unsigned lines, bool wide,
+                                    std::uint64_t& hit)
+    {
+        const unsigned  w = width();
+        const unsigned  h = height();
+        const unsigned  bytes = wide ? 2 : 1;
+        std::uint64_t   touched = 0;
+
+        // Sprites start on screen, but may be cut at its edges
+        x &= w - 1;
+        y &= h - 1;
+        if (Clip)
+            lines = std::min(lines, h - y);
+
+        // At low resolution, rows are single words
+        if (!hires_)
+        {
+            for (unsigned line = 0; line < lines; ++line)
+            {
+                std::uint64_t sprite = static_cast<std::uint64_t>(
+                        memory[(address + line) & 0xFFFF]) << 56;
+                if (Clip)
+                    sprite >>= x;
+                else if (x != 0)
+                    sprite = (sprite >> x) | (sprite << (64 - x));
+
+                unsigned        row = (y + line) & (h - 1);
+                std::uint64_t&  pixels = rows_[row][word];
+                hit |= pixels & sprite;
+                pixels ^= sprite;
+                touched |= static_cast<std::uint64_t>(sprite != 0) << row;
+            }
+
+            return touched;
+        }
+
+        for (unsigned line = 0; line < lines; ++line)
+        {
+            unsigned        at = address + line * bytes;
+            std::uint64_t   bits = static_cast<std::uint64_t>(
+                    memory[at & 0xFFFF]) << 56;
+            if (wide)
+                bits |= static_cast<std::uint64_t>(
+                        memory[(at + 1) & 0xFFFF]) << 48;
+
+            // Move the sprite to column x, across both words
+            std::uint64_t left = bits;
+            std::uint64_t right = 0;
+            if (x >= 64)
+            {
+                right = bits >> (x - 64);
+                left = Clip || x == 64 ? 0 : bits << (128 - x);
+            }
+            else if (x != 0)
+            {
+                right = bits << (64 - x);
+                left = bits >> x;
+            }
+
+            unsigned        row = (y + line) & (h - 1);
+            std::uint64_t*  pixels = &rows_[row][word];
+            hit |= (pixels[0] & left) | (pixels[1] & right);
+            pixels[0] ^= left;
+            pixels[1] ^= right;
+            touched |= static_cast<std::uint64_t>((left | right) != 0) << row;
+        }
+
+        return touched;
+    }
+
+
+    inline std::uint64_t Screen::scrollDown(unsigned n)
+    {
+        std::uint64_t   rows = occupied();
+        unsigned        h = height();
+
+        n = std::min(n, h);
+        for (unsigned word = 0; word < 2 * PLANES; ++word)
+            if (planes_ & (1 << word / 2))
+                for (unsigned y = h; y-- > 0; )
+                    rows_[y][word] = y >= n ? rows_[y - n][word] : 0;
+        return rows | occupied();
+    }
+
+
+    inline std::uint64_t Screen::scrollUp(unsigned n)
+    {
+        std::uint64_t   rows = occupied();
+        unsigned        h = height();
+
+        n = std::min(n, h);
+        for (unsigned word = 0; word < 2 * PLANES; ++word)
+            if (planes_ & (1 << word / 2))
+                for (unsigned y = 0; y < h; ++y)
+                    rows_[y][word] = y + n < h ? rows_[y + n][word] : 0;
+        return rows | occupied();
+    }
+
+
+    inline std::uint64_t Screen::scrollRight()
+    {
+        std::uint64_t rows = occupied();
+
+        for (unsigned plane = 0; plane < PLANES; ++plane)
+        {
+            if (!(planes_ & (1 << plane)))
+                continue;
+            for (unsigned y = 0; y < height(); ++y)
+            {
+                std::uint64_t* words = &rows_[y][2 * plane];
+
+                if (hires_)
+                    words[1] = (words[1] >> 4) | (words[0] << 60);
+                words[0] >>= 4;
+            }
+        }
+        return rows;
+    }
+
+
+    inline std::uint64_t Screen::scrollLeft()
+    {
+        std::uint64_t rows = occupied();
+
+        for (unsigned plane = 0; plane < PLANES; ++plane)
+        {
+            if (!(planes_ & (1 << plane)))
+                continue;
+            for (unsigned y = 0; y < height(); ++y)
+            {
+                std::uint64_t* words = &rows_[y][2 * plane];
+
+                words[0] = (words[0] << 4) | (words[1] >> 60);
+                words[1] <<= 4;
+            }
+        }
+        return rows;
+    }
+}
+
+#endif /* !SCREEN_HH_ */
@@ -0,0 +1,135 @@
+#ifndef SNAPSHOT_HH_
+# define SNAPSHOT_HH_
+
+# include <atomic>
+# include <cstdint>
+# include <cstring>
+# include <fstream>
+# include <vector>
+
+namespace chip8
+{
+    // Saved states start with this magic and version, the version being
+    // bumped on any layout change. Fields are stored in host byte order
+    static const char           STATE_MAGIC[4] = { 'C', '8', 'S', 'V' };
+    static const std::uint32_t  STATE_VERSION = 5;
+
+    /// @struct Snapshot
+    /// @brief Saved machine state. A snapshot last written by a machine is
+    /// updated in place by its next saveState(), which then only copies the
+    /// memory pages written in between, and lists the ranges of data it
+    /// did write: bytes outside of them are as the save before left them.
+    /// Loading it back into that machine likewise only copies the pages
+    /// written since
+    struct Snapshot
+    {
+        struct Range
+        {
+            std::uint32_t   begin;
+            std::uint32_t   end;
+        };
+
+        // Record that the last save wrote [begin, end), in increasing order
+        void wrote(std::uint32_t begin, std::uint32_t end)
+        {
+            if (!written.empty() && written.back().end == begin)
+                written.back().end = end;
+            else
+                written.push_back(Range { begin, end });
+        }
+
+        std::vector<unsigned char>  data;
+        std::uint64_t               epoch = 0; // Identifies the last save
+        std::vector<Range>          written; // By the last save
+    };
+
+
+    // Fresh Snapshot::epoch, unique across every machine of the process
+    inline std::uint64_t nextEpoch()
+    {
+        static std::atomic<std::uint64_t> epoch(0);
+        return ++epoch;
+    }
+
+
+    /// @class StateWriter
+    /// @brief Appends fields to a saved state buffer large enough for them
+    class StateWriter
+    {
+        public:
+            explicit StateWriter(unsigned char* data) : data_(data) {}
+
+            template <typename T>
+            void put(const T& value)
+            {
+                std::memcpy(data_, &value, sizeof (value));
+                data_ += sizeof (value);
+            }
+
+            unsigned char* skip(std::size_t size)
+            {
+                unsigned char* at = data_;
+                data_ += size;
+                return at;
+            }
+
+        private:
+            unsigned char*  data_;
+    };
+
+
+    /// @class StateReader
+    /// @brief Reads fields back from a saved state, failing past its end
+    class StateReader
+    {
+        public:
+            StateReader(const unsigned char* data, std::size_t size)
+                : data_(data)
+                , size_(size)
+            {
+            }
+
+            // value, zeroed when past the end
+            template <typename T>
+            bool get(T& value)
+            {
+                if (size_ < sizeof (value))
+                {
+                    std::memset(&value, 0, sizeof (value));
+                    return false;
+                }
+                std::memcpy(&value, data_, sizeof (value));
+                data_ += sizeof (value);
+                size_ -= sizeof (value);
+                return true;
+            }
+
+            // Next size bytes, read in place, nullptr past the end
+            const unsigned char* skip(std::size_t size)
+            {
+                const unsigned char* at = data_;
+
+                if (size_ < size)
+                    return nullptr;
+                data_ += size;
+                size_ -= size;
+                return at;
+            }
+
+        private:
+            const unsigned char*    data_;
+            std::size_t             size_;
+    };
+
+
+    inline bool writeSnapshot(const char* path, const Snapshot& snapshot)
+    {
+        std::ofstream ofs(path, std::ofstream::out | std::ofstream::binary);
+
+        ofs.write(reinterpret_cast<const char*>(snapshot.data.data()),
+                  snapshot.data.size());
+        return ofs.good();
+    }
+}
+
+#endif /* !SNAPSHOT_HH_ */
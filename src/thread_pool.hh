@@ -0,0 +1,173 @@
+#ifndef THREAD_POOL_HH_
+# define THREAD_POOL_HH_
+
+# include <algorithm>
+# include <condition_variable>
+# include <deque>
+# include <functional>
+# include <memory>
+# include <mutex>
+# include <thread>
+# include <vector>
+
+namespace chip8
+{
+    /// @class ThreadPool
+    /// @brief Fixed set of workers, each with its own deque of tasks. A
+    /// worker runs its newest task first and, once out of work, steals the
+    /// oldest task of another worker
+    class ThreadPool
+    {
+        public:
+            typedef std::function<void()> Task;
+
+            explicit ThreadPool(unsigned workers = 0);
+            // Finish every submitted task, then stop the workers
+            ~ThreadPool();
+
+            void submit(Task task);
+            // Block until every submitted task has run
+            void wait();
+
+            unsigned size() const { return threads_.size(); }
+
+        private:
+            struct Queue
+            {
+                std::mutex          mutex;
+                std::deque<Task>    tasks;
+            };
+
+            void work(unsigned index);
+            bool pop(unsigned index, Task& task);
+            bool steal(unsigned index, Task& task);
+
+            std::vector<std::unique_ptr<Queue>> queues_;
+            std::vector<std::thread>            threads_;
+
+            std::mutex                          mutex_;
+            std::condition_variable             wake_; // Tasks to run
+            std::condition_variable             done_; // Nothing pending
+            unsigned long                       queued_; // Not started yet
+            unsigned long                       pending_; // Not finished yet
+            unsigned                            next_; // Queue for submit()
+            bool                                stop_;
+    };
+
+
+    inline ThreadPool::ThreadPool(unsigned workers)
+        : queued_(0)
+        , pending_(0)
+        , next_(0)
+        , stop_(false)
+    {
+        if (workers == 0)
+            workers = std::max(1u, std::thread::hardware_concurrency());
+
+        for (unsigned i = 0; i < workers; ++i)
+            queues_.emplace_back(new Queue);
+        for (unsigned i = 0; i < workers; ++i)
+            threads_.emplace_back(&ThreadPool::work, this, i);
+    }
+
+
+    inline ThreadPool::~ThreadPool()
+    {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+
+        for (auto& thread : threads_)
+            thread.join();
+    }
+
+
+    inline void ThreadPool::submit(Task task)
+    {
+        // Counted first, so that a worker never finishes it before
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++queued_;
+            ++pending_;
+        }
+
+        Queue& queue = *queues_[next_++ % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        wake_.notify_one();
+    }
+
+
+    inline void ThreadPool::wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+
+    inline bool ThreadPool::pop(unsigned index, Task& task)
+    {
+        Queue& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty())
+            return false;
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+
+    inline bool ThreadPool::steal(unsigned index, Task& task)
+    {
+        for (unsigned i = 1; i < queues_.size(); ++i)
+        {
+            Queue& queue = *queues_[(index + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    inline void ThreadPool::work(unsigned index)
+    {
+        Task task;
+
+        for (;;)
+        {
+            if (pop(index, task) || steal(index, task))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --queued_;
+                }
+                task();
+                task = nullptr;
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0)
+                    done_.notify_all();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+            if (stop_ && queued_ == 0)
+                return;
+        }
+    }
+}
+
+#endif /* !THREAD_POOL_HH_ */
@@ -0,0 +1,219 @@
+#ifndef TRACE_HH_
+# define TRACE_HH_
+
+# include <algorithm>
+# include <atomic>
+# include <chrono>
+# include <cstdint>
+# include <cstdio>
+# include <ostream>
+# include <thread>
+# include <vector>
+# include "opcodes.hh"
+# include "utility.hh"
+
+namespace chip8
+{
+    // Trace files start with this magic and version, followed by
+    // TraceRecords, all in host byte order
+    static const char           TRACE_MAGIC[4] = { 'C', '8', 'T', 'R' };
+    static const std::uint32_t  TRACE_VERSION = 1;
+
+    /// @struct TraceRecord
+    /// @brief One executed instruction, with the registers it may have
+    /// changed as they were after it
+    struct TraceRecord
+    {
+        std::uint64_t   cycle;
+        std::uint16_t   pc;
+        std::uint16_t   opcode;
+        std::uint16_t   I;
+        std::uint8_t    vx; // VX, X being the one of opcode
+        std::uint8_t    vf;
+    };
+
+    static_assert(sizeof (TraceRecord) == 16, "TraceRecord must be packed");
+
+
+    /// @class Trace
+    /// @brief Instrumentation policy of Chip8 writing a TraceRecord for
+    /// every instruction executed to a file.
+    ///
+    /// Records go through a single producer, single consumer ring drained
+    /// by a background thread, so the emulation only waits when the ring is
+    /// full. The producer only publishes its position every few records
+    class Trace
+    {
+        public:
+            static const bool enabled = true;
+
+            Trace();
+            ~Trace() { close(); }
+
+            Trace(const Trace&) = delete;
+            Trace& operator=(const Trace&) = delete;
+
+            // Start tracing to path, numbering records from cycle
+            bool open(const char* path, std::uint64_t cycle = 0);
+            // Write every pending record and stop tracing
+            bool close();
+
+            CHIP8_INLINE void instruction(unsigned pc, Opcode)
+            {
+                pc_ = pc;
+            }
+
+            void call(unsigned) {}
+
+            // Instruction just executed by machine
+            template <typename Machine, typename Instr>
+            void retire(const Machine& machine, const Instr& instr);
+
+            // Write the number of records traced
+            void report(std::ostream& os, unsigned = 20) const;
+
+        private:
+            static const std::size_t    CAPACITY = 1 << 16; // Records
+            static const std::size_t    BATCH = 64; // Records per publication
+
+            // Wait for a free slot, the ring being full
+            void wait();
+            // Background thread writing records to file_
+            void drain();
+
+            std::vector<TraceRecord>    ring_;
+            std::FILE*                  file_;
+            std::thread                 writer_;
+            std::atomic<bool>           stop_;
+            bool                        ok_;
+
+            // Producer side
+            std::uint64_t               cycle_;
+            unsigned                    pc_;
+            std::size_t                 head_; // Next record to write
+            std::size_t                 freeUntil_; // Last known free slot
+
+            // Shared
+            std::atomic<std::size_t>    published_; // Records readable
+            std::atomic<std::size_t>    consumed_; // Records written out
+    };
+
+
+    inline Trace::Trace()
+        : ring_(CAPACITY)
+        , file_(nullptr)
+        , stop_(false)
+        , ok_(true)
+        , cycle_(0)
+        , pc_(0)
+        , head_(0)
+        , freeUntil_(CAPACITY)
+        , published_(0)
+        , consumed_(0)
+    {
+    }
+
+
+    inline bool Trace::open(const char* path, std::uint64_t cycle)
+    {
+        close();
+
+        file_ = std::fopen(path, "wb");
+        if (file_ == nullptr)
+            return false;
+
+        ok_ = std::fwrite(TRACE_MAGIC, sizeof (TRACE_MAGIC), 1, file_) == 1
+            && std::fwrite(&TRACE_VERSION, sizeof (TRACE_VERSION), 1,
+                           file_) == 1;
+        cycle_ = cycle;
+        head_ = 0;
+        freeUntil_ = CAPACITY;
+        published_ = 0;
+        consumed_ = 0;
+        stop_ = false;
+        writer_ = std::thread(&Trace::drain, this);
+        return ok_;
+    }
+
+
+    inline bool Trace::close()
+    {
+        if (file_ == nullptr)
+            return ok_;
+
+        published_.store(head_, std::memory_order_release);
+        stop_.store(true, std::memory_order_release);
+        writer_.join();
+
+        ok_ = std::fclose(file_) == 0 && ok_;
+        file_ = nullptr;
+        return ok_;
+    }
+
+
+    template <typename Machine, typename Instr>
+    CHIP8_INLINE void Trace::retire(const Machine& machine, const Instr& instr)
+    {
+        if (file_ == nullptr)
+            return;
+        if (head_ == freeUntil_)
+            wait();
+
+        TraceRecord& record = ring_[head_ % CAPACITY];
+        record.cycle = cycle_++;
+        record.pc = pc_;
+        record.opcode = instr.opcode;
+        record.I = machine.index();
+        record.vx = machine.registers()[instr.x];
+        record.vf = machine.registers()[15];
+
+        if (++head_ % BATCH == 0)
+            published_.store(head_, std::memory_order_release);
+    }
+
+
+    inline void Trace::wait()
+    {
+        published_.store(head_, std::memory_order_release);
+        while ((freeUntil_ = consumed_.load(std::memory_order_acquire)
+                + CAPACITY) == head_)
+            std::this_thread::yield();
+    }
+
+
+    inline void Trace::drain()
+    {
+        for (;;)
+        {
+            // Read stop_ first: every record is published before it is set
+            bool        stop = stop_.load(std::memory_order_acquire);
+            std::size_t tail = consumed_.load(std::memory_order_relaxed);
+            std::size_t head = published_.load(std::memory_order_acquire);
+
+            if (tail == head)
+            {
+                if (stop)
+                    return;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            // Up to the end of the ring, the rest on the next round
+            std::size_t begin = tail % CAPACITY;
+            std::size_t count = std::min(head - tail, CAPACITY - begin);
+
+            if (std::fwrite(&ring_[begin], sizeof (TraceRecord), count, file_)
+                != count)
+                ok_ = false;
+            consumed_.store(tail + count, std::memory_order_release);
+        }
+    }
+
+
+    inline void Trace::report(std::ostream& os, unsigned) const
+    {
+        os << "traced " << head_ << " instructions\n";
+    }
+}
+
+#endif /* !TRACE_HH_ */
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include "mapped_file.hh"
+#include "opcodes.hh"
+#include "trace.hh"
+
+namespace
+{
+    int usage(const char* name)
+    {
+        std::cerr << "usage: " << name << " TRACE [options]\n"
+            "  --from CYCLE  first cycle to print (default: first traced)\n"
+            "  --count N     records to print (default: all of them)\n"
+            "Prints \"CYCLE PC OPCODE NAME I VX VF\" lines, registers being\n"
+            "as they were after the instruction\n";
+        return 1;
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char*         path = nullptr;
+    std::uint64_t       from = 0;
+    std::uint64_t       count = ~std::uint64_t(0);
+    chip8::MappedFile   file;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--from") == 0 && hasValue)
+            from = std::strtoull(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--count") == 0 && hasValue)
+            count = std::strtoull(argv[++i], nullptr, 0);
+        else if (argv[i][0] != '-' && path == nullptr)
+            path = argv[i];
+        else
+            return usage(argv[0]);
+    }
+
+    if (path == nullptr)
+        return usage(argv[0]);
+
+    std::size_t     header = sizeof (chip8::TRACE_MAGIC)
+        + sizeof (chip8::TRACE_VERSION);
+    std::uint32_t   version = 0;
+
+    if (file.open(path) && file.size() >= header
+        && std::memcmp(file.data(), chip8::TRACE_MAGIC,
+                       sizeof (chip8::TRACE_MAGIC)) == 0)
+        std::memcpy(&version, file.data() + sizeof (chip8::TRACE_MAGIC),
+                    sizeof (version));
+    if (version != chip8::TRACE_VERSION)
+    {
+        std::cerr << "Invalid trace: " << path << std::endl;
+        return 1;
+    }
+
+    std::size_t records = (file.size() - header) / sizeof (chip8::TraceRecord);
+    std::size_t first = 0;
+    chip8::TraceRecord record;
+
+    // Records are numbered by consecutive cycles
+    if (records > 0)
+    {
+        std::memcpy(&record, file.data() + header, sizeof (record));
+        if (from > record.cycle)
+            first = std::min<std::uint64_t>(from - record.cycle, records);
+    }
+
+    std::cout << std::hex << std::setfill('0');
+    for (std::size_t i = first; i < records && i - first < count; ++i)
+    {
+        std::memcpy(&record, file.data() + header + i * sizeof (record),
+                    sizeof (record));
+
+        std::cout << std::dec << record.cycle << std::hex
+            << ' ' << std::setw(3) << record.pc
+            << ' ' << std::setw(4) << record.opcode
+            << ' ' << chip8::opcodeName(chip8::getOpcode(record.opcode))
+            << " I=" << std::setw(3) << record.I
+            << " V" << chip8::get<1>(record.opcode)
+            << '=' << std::setw(2) << unsigned(record.vx)
+            << " VF=" << std::setw(2) << unsigned(record.vf) << '\n';
+    }
+
+    return 0;
+}
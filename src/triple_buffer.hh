@@ -0,0 +1,76 @@
+#ifndef TRIPLE_BUFFER_HH_
+# define TRIPLE_BUFFER_HH_
+
+# include <atomic>
+
+namespace chip8
+{
+    /// @class TripleBuffer
+    /// @brief Hands the latest of a stream of values from one writer thread
+    /// to one reader thread without either ever waiting for the other.
+    ///
+    /// The writer fills the back slot and publishes it by swapping it with
+    /// the middle one; the reader takes the middle slot, when it holds a
+    /// value newer than the front one it has, by swapping it with the
+    /// front one. Values published faster than they are read replace each
+    /// other in the middle slot
+    template <typename T>
+    class TripleBuffer
+    {
+        public:
+            TripleBuffer();
+
+            // Writer: slot to fill, then publish
+            T& back() { return slots_[back_]; }
+            // Writer: make back() the latest value, and give a new back()
+            // slot. False if the value it replaces was never read, in
+            // which case the new back() still holds it
+            bool publish();
+
+            // Reader: take the latest value into front(), if newer than
+            // the one already there
+            bool update();
+            const T& front() const { return slots_[front_]; }
+
+        private:
+            static const unsigned FRESH = 4; // Middle slot not read yet
+
+            T                       slots_[3];
+            unsigned                back_;
+            std::atomic<unsigned>   middle_; // Index | FRESH
+            unsigned                front_;
+    };
+
+
+    template <typename T>
+    TripleBuffer<T>::TripleBuffer()
+        : back_(0)
+        , middle_(1)
+        , front_(2)
+    {
+    }
+
+
+    template <typename T>
+    bool TripleBuffer<T>::publish()
+    {
+        unsigned middle = middle_.exchange(back_ | FRESH,
+                                           std::memory_order_acq_rel);
+
+        back_ = middle & ~FRESH;
+        return (middle & FRESH) == 0;
+    }
+
+
+    template <typename T>
+    bool TripleBuffer<T>::update()
+    {
+        if ((middle_.load(std::memory_order_relaxed) & FRESH) == 0)
+            return false;
+
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~FRESH;
+        return true;
+    }
+}
+
+#endif /* !TRIPLE_BUFFER_HH_ */
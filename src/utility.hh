@@ -1,6 +1,15 @@
 #ifndef UTILITY_HH_
 # define UTILITY_HH_
 
+# include <cstddef>
+# include <cstdint>
+
+# if defined(__GNUC__)
+#  define CHIP8_INLINE inline __attribute__((always_inline))
+# else
+#  define CHIP8_INLINE inline
+# endif
+
 namespace chip8
 {
     // Used to retreive some part of a 16-bits word
@@ -31,6 +40,34 @@ namespace chip8
     }
 # endif
 
+    // 64-bits FNV-1a hash, chained through hash
+    inline std::uint64_t fnv1a(const void* data, std::size_t size,
+                               std::uint64_t hash = 0xCBF29CE484222325ULL)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ULL;
+        }
+        return hash;
+    }
+
+    // Index of the lowest set bit of a non-zero value
+    inline unsigned lowestBit(std::uint64_t bits)
+    {
+# if defined(__GNUC__)
+        return __builtin_ctzll(bits);
+# else
+        unsigned index = 0;
+
+        for (; !(bits & 1); bits >>= 1)
+            ++index;
+        return index;
+# endif
+    }
+
     unsigned char chip8_fontset[80] =
     {
         0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
@@ -51,45 +88,28 @@ namespace chip8
         0xF0, 0x80, 0xF0, 0x80, 0x80  // F
     };
 
+    // SUPER-CHIP 8x10 digits, loaded right after chip8_fontset
+    static const unsigned BIG_FONT_ADDRESS = 80;
 
-    unsigned getKey()
+    unsigned char chip8_bigfontset[160] =
     {
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num1))
-            return 0;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num2))
-            return 1;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num3))
-            return 2;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num4))
-            return 3;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
-            return 4;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
-            return 5;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
-            return 6;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::R))
-            return 7;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-            return 8;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
-            return 9;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-            return 10;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::F))
-            return 11;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Z))
-            return 12;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::X))
-            return 13;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::C))
-            return 14;
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::V))
-            return 15;
-        else
-            return 16;
-
-    }
+        0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+        0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+        0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+        0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+        0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+        0x3E, 0x7C, 0xE0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+        0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+        0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+        0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // 9
+        0x3C, 0x7E, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, // A
+        0xFC, 0xFE, 0xC3, 0xC3, 0xFE, 0xFE, 0xC3, 0xC3, 0xFE, 0xFC, // B
+        0x3C, 0x7E, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0x7E, 0x3C, // C
+        0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xFF, 0xFF, // E
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xC0, 0xC0  // F
+    };
 }
 
 #endif /* !UTILITY_HH_ */
@@ -0,0 +1,631 @@
+#ifndef WIDE_HH_
+# define WIDE_HH_
+
+# include <algorithm>
+# include <array>
+# include <cstdint>
+# include <cstring>
+# include "input.hh"
+# include "opcodes.hh"
+# include "quirks.hh"
+# include "random.hh"
+# include "rom.hh"
+# include "screen.hh"
+# include "utility.hh"
+
+namespace chip8
+{
+    /// @class Wide
+    /// @brief Lanes instances of the same game run in lockstep, for
+    /// searches over many input sequences or seeds.
+    ///
+    /// Registers, I, pc, stacks and timers are stored as one array per
+    /// field indexed by lane, so that the lanes executing an instruction
+    /// update them in loops the compiler turns into SIMD code (SSE2, AVX2
+    /// with -mavx2, plain scalar code elsewhere). Each step runs the lanes
+    /// at the lowest pc together, the others being masked out until they
+    /// reconverge there. Memory and screen stay per lane.
+    ///
+    /// Every lane behaves exactly as a Chip8 with the same Quirks policy,
+    /// initialized with seed + lane and given the same keys, would
+    template <unsigned Lanes = 32, typename Quirks = DefaultQuirks>
+    class Wide
+    {
+        public:
+            void initialize(std::uint64_t seed = 0);
+            // Load a game at 0x200 in every lane, as Chip8::loadGame()
+            bool loadGame(const unsigned char* data, std::size_t size);
+            // Execute n instructions in every lane
+            void run(unsigned long n);
+            void updateTimers();
+
+            void pressKey(unsigned lane, unsigned key);
+            void releaseKey(unsigned lane, unsigned key);
+
+            // State of one lane
+            const Screen& screen(unsigned lane) const { return screen_[lane]; }
+            std::uint8_t reg(unsigned lane, unsigned x) const
+            {
+                return V_[x][lane];
+            }
+            std::uint16_t index(unsigned lane) const { return I_[lane]; }
+            std::uint16_t pc(unsigned lane) const { return pc_[lane]; }
+            std::uint8_t delayTimer(unsigned lane) const { return delay_[lane]; }
+            std::uint8_t soundTimer(unsigned lane) const { return sound_[lane]; }
+            // Same as Chip8::digest() for this lane
+            std::uint64_t digest(unsigned lane) const;
+
+        private:
+            typedef Instruction<std::uint8_t, std::uint16_t> Instr;
+
+            // Pick the lanes of the next step into active_, returning the
+            // instruction they execute, or nullptr when every lane is done
+            const Instr* group();
+            // Execute instr in the active_ lanes
+            void execute(const Instr& instr);
+            void drawSprite(unsigned lane, const Instr& instr);
+            void store(unsigned lane, unsigned address, std::uint8_t value);
+            // Length of the instruction at the pc of lane, F000 NNNN being
+            // twice as long, for skips
+            std::uint16_t length(unsigned lane) const;
+
+            // Lane masks, from active_
+            static std::uint8_t mask8(std::uint8_t active)
+            {
+                return -active;
+            }
+            static std::uint16_t mask16(std::uint8_t active)
+            {
+                return -std::uint16_t(active);
+            }
+
+            // Per lane fields, indexed by lane
+            std::uint8_t                V_[16][Lanes]; // Registers
+            std::uint16_t               I_[Lanes];
+            std::uint16_t               pc_[Lanes]; // Below 0x1000
+            std::uint16_t               sp_[Lanes]; // Wraps like Chip8
+            std::uint16_t               stack_[16][Lanes];
+            std::uint8_t                delay_[Lanes];
+            std::uint8_t                sound_[Lanes];
+            std::uint16_t               keys_[Lanes]; // Bit k for key k held
+            std::uint8_t                await_[Lanes]; // FX0A progress
+            std::uint32_t               budget_[Lanes]; // Left in this chunk
+            std::uint8_t                active_[Lanes]; // 1 in this step
+            Screen                      screen_[Lanes];
+            std::array<std::uint8_t, 16> flags_[Lanes]; // RPL user flags
+            std::array<std::uint8_t, 16> pattern_[Lanes]; // Audio samples
+            std::uint8_t                pitch_[Lanes];
+            std::uint8_t                memory_[Lanes][MEMORY_SIZE];
+            Random                      random_[Lanes];
+
+            // Shared
+            std::array<Instr, 4096>     cache_; // Pre-decoded instructions
+            std::array<bool, 4096>      diverged_; // Written by some lane
+    };
+
+
+    template <unsigned Lanes, typename Quirks>
+    void Wide<Lanes, Quirks>::initialize(std::uint64_t seed)
+    {
+        std::memset(V_, 0, sizeof (V_));
+        std::memset(stack_, 0, sizeof (stack_));
+        std::memset(memory_, 0, sizeof (memory_));
+
+        for (unsigned lane = 0; lane < Lanes; ++lane)
+        {
+            I_[lane] = 0;
+            pc_[lane] = 0x200;
+            sp_[lane] = 0;
+            delay_[lane] = 0;
+            sound_[lane] = 0;
+            keys_[lane] = 0;
+            await_[lane] = AWAIT_IDLE;
+            screen_[lane] = Screen();
+            flags_[lane].fill(0);
+            pattern_[lane].fill(0);
+            pitch_[lane] = 64;
+            std::memcpy(memory_[lane], chip8_fontset, sizeof (chip8_fontset));
+            std::memcpy(memory_[lane] + BIG_FONT_ADDRESS, chip8_bigfontset,
+                        sizeof (chip8_bigfontset));
+            random_[lane].reseed(seed + lane);
+        }
+
+        for (auto& instr : cache_)
+            instr.op = Instr::UNDECODED;
+        diverged_.fill(false);
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    bool Wide<Lanes, Quirks>::loadGame(const unsigned char* data,
+                                       std::size_t size)
+    {
+        if (size > ROM_CAPACITY)
+            return false;
+
+        // An empty ROM, e.g. mapped from an empty file, may have no data
+        for (unsigned lane = 0; lane < Lanes && size > 0; ++lane)
+            std::memcpy(&memory_[lane][ROM_ADDRESS], data, size);
+        for (auto& instr : cache_)
+            instr.op = Instr::UNDECODED;
+        return true;
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    void Wide<Lanes, Quirks>::pressKey(unsigned lane, unsigned key)
+    {
+        if (lane < Lanes && key < 16)
+        {
+            keys_[lane] |= 1 << key;
+            await_[lane] = awaitPress(await_[lane], key);
+        }
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    void Wide<Lanes, Quirks>::releaseKey(unsigned lane, unsigned key)
+    {
+        if (lane < Lanes && key < 16)
+        {
+            keys_[lane] &= ~(1 << key);
+            await_[lane] = awaitRelease(await_[lane], key);
+        }
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    void Wide<Lanes, Quirks>::updateTimers()
+    {
+        for (unsigned lane = 0; lane < Lanes; ++lane)
+        {
+            delay_[lane] -= delay_[lane] > 0;
+            sound_[lane] -= sound_[lane] > 0;
+        }
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    std::uint64_t Wide<Lanes, Quirks>::digest(unsigned lane) const
+    {
+        std::uint8_t    registers[16];
+        std::uint16_t   stack[16];
+        std::uint64_t   random = random_[lane].state();
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            registers[i] = V_[i][lane];
+            stack[i] = stack_[i][lane];
+        }
+
+        std::uint64_t hash = fnv1a(memory_[lane], sizeof (memory_[lane]));
+        hash = fnv1a(registers, sizeof (registers), hash);
+        hash = fnv1a(&I_[lane], sizeof (I_[lane]), hash);
+        hash = fnv1a(&pc_[lane], sizeof (pc_[lane]), hash);
+        hash = fnv1a(screen_[lane].rows().data(),
+                     sizeof (screen_[lane].rows()), hash);
+        std::uint8_t hires = screen_[lane].hires();
+        hash = fnv1a(&hires, sizeof (hires), hash);
+        std::uint8_t planes = screen_[lane].planes();
+        hash = fnv1a(&planes, sizeof (planes), hash);
+        hash = fnv1a(flags_[lane].data(), flags_[lane].size(), hash);
+        hash = fnv1a(pattern_[lane].data(), pattern_[lane].size(), hash);
+        hash = fnv1a(&pitch_[lane], sizeof (pitch_[lane]), hash);
+        hash = fnv1a(&delay_[lane], sizeof (delay_[lane]), hash);
+        hash = fnv1a(&sound_[lane], sizeof (sound_[lane]), hash);
+        hash = fnv1a(stack, sizeof (stack), hash);
+        hash = fnv1a(&sp_[lane], sizeof (sp_[lane]), hash);
+        hash = fnv1a(&await_[lane], sizeof (await_[lane]), hash);
+        hash = fnv1a(&random, sizeof (random), hash);
+        return hash;
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    void Wide<Lanes, Quirks>::run(unsigned long n)
+    {
+        // Budgets are 32 bits, vectorizing better than 64 bits: longer
+        // runs go in chunks, lanes being independent
+        static const unsigned long CHUNK = 0xFFFFFFFFUL;
+
+        for (; n > 0; n -= std::min(n, CHUNK))
+        {
+            for (unsigned lane = 0; lane < Lanes; ++lane)
+                budget_[lane] = std::min(n, CHUNK);
+
+            while (const Instr* instr = group())
+            {
+                for (unsigned lane = 0; lane < Lanes; ++lane)
+                {
+                    pc_[lane] = (pc_[lane] + (mask16(active_[lane]) & 2))
+                        & 0x0FFF;
+                    budget_[lane] -= active_[lane];
+                }
+                execute(*instr);
+                // As Chip8, pc stays within the 4 KiB programs run from
+                for (unsigned lane = 0; lane < Lanes; ++lane)
+                    pc_[lane] &= 0x0FFF;
+            }
+        }
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    const typename Wide<Lanes, Quirks>::Instr*
+    Wide<Lanes, Quirks>::group()
+    {
+        std::uint16_t   at[Lanes];
+        std::uint16_t   lowest = 0xFFFF;
+
+        // Lowest pc among the lanes with instructions left to run
+        for (unsigned lane = 0; lane < Lanes; ++lane)
+        {
+            std::uint16_t done = -std::uint16_t(budget_[lane] == 0);
+
+            at[lane] = pc_[lane] | done;
+            lowest = std::min(lowest, at[lane]);
+        }
+        if (lowest == 0xFFFF)
+            return nullptr;
+
+        for (unsigned lane = 0; lane < Lanes; ++lane)
+            active_[lane] = at[lane] == lowest;
+
+        unsigned        next = (lowest + 1) & 0x0FFF;
+        unsigned        first = 0;
+        while (!active_[first])
+            ++first;
+        std::uint16_t   opcode = (memory_[first][lowest] << 8)
+            | memory_[first][next];
+
+        // Lanes that rewrote this instruction to something else wait for
+        // a step of their own
+        if (diverged_[lowest] || diverged_[next])
+            for (unsigned lane = first + 1; lane < Lanes; ++lane)
+                if (active_[lane] && ((memory_[lane][lowest] << 8)
+                                      | memory_[lane][next]) != opcode)
+                    active_[lane] = 0;
+
+        Instr& instr = cache_[lowest];
+        if (instr.op == Instr::UNDECODED || instr.opcode != opcode)
+            instr = predecode<std::uint8_t, std::uint16_t>(opcode);
+        return &instr;
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    void Wide<Lanes, Quirks>::store(unsigned lane, unsigned address,
+                                    std::uint8_t value)
+    {
+        address &= 0xFFFF;
+        memory_[lane][address] = value;
+        if (address < diverged_.size())
+            diverged_[address] = true;
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    std::uint16_t Wide<Lanes, Quirks>::length(unsigned lane) const
+    {
+        unsigned pc = pc_[lane];
+
+        return memory_[lane][pc] == 0xF0
+            && memory_[lane][(pc + 1) & 0x0FFF] == 0x00 ? 4 : 2;
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    void Wide<Lanes, Quirks>::drawSprite(unsigned lane, const Instr& instr)
+    {
+        Screen& screen = screen_[lane];
+        bool    wide = (instr.nn & 0x0F) == 0 && screen.hires();
+        bool    collision;
+
+        screen.draw<Quirks::clipsSprites>(
+                memory_[lane], I_[lane], V_[instr.x][lane], V_[instr.y][lane],
+                wide ? 16 : instr.nn & 0x0F, wide, collision);
+        V_[15][lane] = collision;
+    }
+
+
+    template <unsigned Lanes, typename Quirks>
+    void Wide<Lanes, Quirks>::execute(const Instr& instr)
+    {
+        std::uint8_t*       vx = V_[instr.x];
+        const std::uint8_t* vy = V_[instr.y];
+        std::uint8_t*       vf = V_[15];
+        std::uint8_t*       active = active_;
+
+        // Same semantics as Chip8::decode(), lane by lane. Masks select the
+        // new value in active lanes and keep the old one elsewhere
+# define CHIP8_LANES(body)                                              \
+        for (unsigned lane = 0; lane < Lanes; ++lane)                   \
+        {                                                               \
+            std::uint8_t    m8 = mask8(active[lane]);                   \
+            std::uint16_t   m16 = mask16(active[lane]);                 \
+            (void) m8;                                                  \
+            (void) m16;                                                 \
+            body                                                        \
+        }
+# define CHIP8_ACTIVE_LANES(body)                                       \
+        for (unsigned lane = 0; lane < Lanes; ++lane)                   \
+            if (active[lane])                                           \
+            {                                                           \
+                body                                                    \
+            }
+# define CHIP8_BLEND(m, value, old) (((value) & (m)) | ((old) & ~(m)))
+
+        switch (instr.op)
+        {
+            case CLEAR:
+                CHIP8_ACTIVE_LANES(screen_[lane].clear();)
+                break;
+            case SCROLL_DOWN:
+                CHIP8_ACTIVE_LANES(screen_[lane].scrollDown(instr.nn & 0x0F);)
+                break;
+            case SCROLL_UP:
+                CHIP8_ACTIVE_LANES(screen_[lane].scrollUp(instr.nn & 0x0F);)
+                break;
+            case SCROLL_RIGHT:
+                CHIP8_ACTIVE_LANES(screen_[lane].scrollRight();)
+                break;
+            case SCROLL_LEFT:
+                CHIP8_ACTIVE_LANES(screen_[lane].scrollLeft();)
+                break;
+            case EXIT:
+                CHIP8_LANES(pc_[lane] -= m16 & 2;)
+                break;
+            case LOW_RES:
+                CHIP8_ACTIVE_LANES(screen_[lane].resize(false);)
+                break;
+            case HIGH_RES:
+                CHIP8_ACTIVE_LANES(screen_[lane].resize(true);)
+                break;
+            case RETURNS:
+                CHIP8_ACTIVE_LANES(
+                    sp_[lane] = (sp_[lane] - 1) & 15;
+                    pc_[lane] = stack_[sp_[lane]][lane];)
+                break;
+            case JUMP:
+                CHIP8_LANES(pc_[lane] = CHIP8_BLEND(m16, instr.nnn, pc_[lane]);)
+                break;
+            case CALL:
+                CHIP8_ACTIVE_LANES(
+                    stack_[sp_[lane]][lane] = pc_[lane];
+                    sp_[lane] = (sp_[lane] + 1) & 15;
+                    pc_[lane] = instr.nnn;)
+                break;
+            case SKIPS_EQ_XNN:
+                CHIP8_LANES(
+                    std::uint16_t skip = -std::uint16_t(vx[lane] == instr.nn);
+                    pc_[lane] += m16 & skip & length(lane);)
+                break;
+            case SKIPS_NEQ_XNN:
+                CHIP8_LANES(
+                    std::uint16_t skip = -std::uint16_t(vx[lane] != instr.nn);
+                    pc_[lane] += m16 & skip & length(lane);)
+                break;
+            case SKIPS_EQ_XY:
+                CHIP8_LANES(
+                    std::uint16_t skip = -std::uint16_t(vx[lane] == vy[lane]);
+                    pc_[lane] += m16 & skip & length(lane);)
+                break;
+            case SKIPS_NEQ_XY:
+                CHIP8_LANES(
+                    std::uint16_t skip = -std::uint16_t(vx[lane] != vy[lane]);
+                    pc_[lane] += m16 & skip & length(lane);)
+                break;
+            case STORE_XY:
+            case FILLS_XY:
+            {
+                int step = instr.x <= instr.y ? 1 : -1;
+                CHIP8_ACTIVE_LANES(
+                    for (int x = instr.x, i = 0; ; x += step, ++i)
+                    {
+                        if (instr.op == STORE_XY)
+                            store(lane, I_[lane] + i, V_[x][lane]);
+                        else
+                            V_[x][lane] =
+                                memory_[lane][(I_[lane] + i) & 0xFFFF];
+                        if (x == instr.y)
+                            break;
+                    })
+                break;
+            }
+            case SET_XNN:
+                CHIP8_LANES(vx[lane] = CHIP8_BLEND(m8, instr.nn, vx[lane]);)
+                break;
+            case ADD_XNN:
+                CHIP8_LANES(vx[lane] += m8 & instr.nn;)
+                break;
+            case SET_XY:
+                CHIP8_LANES(vx[lane] = CHIP8_BLEND(m8, vy[lane], vx[lane]);)
+                break;
+            case SET_OR_XY:
+                CHIP8_LANES(
+                    vx[lane] |= m8 & vy[lane];
+                    if (Quirks::logicResetsVF)
+                        vf[lane] &= ~m8;)
+                break;
+            case SET_AND_XY:
+                CHIP8_LANES(
+                    vx[lane] &= vy[lane] | ~m8;
+                    if (Quirks::logicResetsVF)
+                        vf[lane] &= ~m8;)
+                break;
+            case SET_XOR_XY:
+                CHIP8_LANES(
+                    vx[lane] ^= m8 & vy[lane];
+                    if (Quirks::logicResetsVF)
+                        vf[lane] &= ~m8;)
+                break;
+            case ADD_CARRY_XY:
+                CHIP8_LANES(
+                    std::uint8_t x = vx[lane];
+                    std::uint8_t sum = x + vy[lane];
+                    vf[lane] = CHIP8_BLEND(m8, sum < x, vf[lane]);
+                    vx[lane] = CHIP8_BLEND(m8, sum, vx[lane]);)
+                break;
+            case SUB_BORROW_XY:
+                CHIP8_LANES(
+                    std::uint8_t x = vx[lane];
+                    std::uint8_t difference = x - vy[lane];
+                    vf[lane] = CHIP8_BLEND(m8, difference < x, vf[lane]);
+                    vx[lane] = CHIP8_BLEND(m8, difference, vx[lane]);)
+                break;
+            case SHIFT_RIGHT_X:
+                // The source is read again after VF is set, as decode()
+                // does, unless it is VY
+                CHIP8_LANES(
+                    const std::uint8_t* source = Quirks::shiftsVY ? vy : vx;
+                    std::uint8_t old = source[lane];
+                    vf[lane] = CHIP8_BLEND(m8, old & 1, vf[lane]);
+                    std::uint8_t x = Quirks::shiftsVY ? old : vx[lane];
+                    vx[lane] = CHIP8_BLEND(m8, x >> 1, vx[lane]);)
+                break;
+            case SHIFT_LEFT_X:
+                CHIP8_LANES(
+                    const std::uint8_t* source = Quirks::shiftsVY ? vy : vx;
+                    std::uint8_t old = source[lane];
+                    vf[lane] = CHIP8_BLEND(m8, old >> 7, vf[lane]);
+                    std::uint8_t x = Quirks::shiftsVY ? old : vx[lane];
+                    vx[lane] = CHIP8_BLEND(m8, x << 1, vx[lane]);)
+                break;
+            case SUB_BORROW_YX:
+                CHIP8_LANES(
+                    std::uint8_t y = vy[lane];
+                    std::uint8_t difference = y - vx[lane];
+                    vf[lane] = CHIP8_BLEND(m8, difference < y, vf[lane]);
+                    vx[lane] = CHIP8_BLEND(m8, difference, vx[lane]);)
+                break;
+            case SET_INN:
+                CHIP8_LANES(I_[lane] = CHIP8_BLEND(m16, instr.nnn, I_[lane]);)
+                break;
+            case JUMP_0NNN:
+                CHIP8_LANES(
+                    std::uint16_t target = instr.nnn
+                        + V_[Quirks::jumpsVX ? instr.x : 0][lane];
+                    pc_[lane] = CHIP8_BLEND(m16, target, pc_[lane]);)
+                break;
+            case RAND:
+                CHIP8_ACTIVE_LANES(
+                    vx[lane] = (random_[lane].next() >> 24) & instr.nn;)
+                break;
+            case DRAW:
+                CHIP8_ACTIVE_LANES(drawSprite(lane, instr);)
+                break;
+            case SKIPS_PRESS:
+                CHIP8_ACTIVE_LANES(
+                    if (keys_[lane] & (1 << (vx[lane] & 0x0F)))
+                        pc_[lane] += length(lane);)
+                break;
+            case SKIPS_NPRESS:
+                CHIP8_ACTIVE_LANES(
+                    if (!(keys_[lane] & (1 << (vx[lane] & 0x0F))))
+                        pc_[lane] += length(lane);)
+                break;
+            case SET_XTIMER:
+                CHIP8_LANES(vx[lane] = CHIP8_BLEND(m8, delay_[lane], vx[lane]);)
+                break;
+            case KEY_AWAIT:
+                CHIP8_ACTIVE_LANES(
+                    if (await_[lane] & AWAIT_RELEASED)
+                    {
+                        vx[lane] = await_[lane] & 0x0F;
+                        await_[lane] = AWAIT_IDLE;
+                    }
+                    else
+                    {
+                        if (await_[lane] == AWAIT_IDLE)
+                            await_[lane] = AWAIT_PRESS;
+                        pc_[lane] -= 2;
+                    })
+                break;
+            case SET_TIMERX:
+                CHIP8_LANES(
+                    delay_[lane] = CHIP8_BLEND(m8, vx[lane], delay_[lane]);)
+                break;
+            case SET_SOUNDX:
+                CHIP8_LANES(
+                    sound_[lane] = CHIP8_BLEND(m8, vx[lane], sound_[lane]);)
+                break;
+            case ADD_IX:
+                CHIP8_LANES(
+                    std::uint16_t i = I_[lane] + (m16 & vx[lane]);
+                    I_[lane] = i;
+                    if (Quirks::addIndexSetsVF)
+                        vf[lane] = CHIP8_BLEND(m8, i > 0xFFF, vf[lane]);)
+                break;
+            case SET_I_SPRITE:
+                CHIP8_LANES(
+                    std::uint16_t sprite = vx[lane] * 5;
+                    I_[lane] = CHIP8_BLEND(m16, sprite, I_[lane]);)
+                break;
+            case SET_I_LONG:
+                CHIP8_ACTIVE_LANES(
+                    unsigned pc = pc_[lane];
+                    I_[lane] = (memory_[lane][pc] << 8)
+                        | memory_[lane][(pc + 1) & 0x0FFF];
+                    pc_[lane] += 2;)
+                break;
+            case SET_PLANE:
+                CHIP8_ACTIVE_LANES(screen_[lane].setPlanes(instr.x);)
+                break;
+            case SET_PATTERN:
+                CHIP8_ACTIVE_LANES(
+                    for (unsigned i = 0; i < 16; ++i)
+                        pattern_[lane][i] =
+                            memory_[lane][(I_[lane] + i) & 0xFFFF];)
+                break;
+            case SET_PITCHX:
+                CHIP8_LANES(
+                    pitch_[lane] = CHIP8_BLEND(m8, vx[lane], pitch_[lane]);)
+                break;
+            case SET_I_BIG_SPRITE:
+                CHIP8_LANES(
+                    std::uint16_t sprite = BIG_FONT_ADDRESS
+                        + (vx[lane] & 0x0F) * 10;
+                    I_[lane] = CHIP8_BLEND(m16, sprite, I_[lane]);)
+                break;
+            case STORE_BINARY:
+                CHIP8_ACTIVE_LANES(
+                    std::uint8_t x = vx[lane];
+                    store(lane, I_[lane], x / 100);
+                    store(lane, I_[lane] + 1, (x / 10) % 10);
+                    store(lane, I_[lane] + 2, x % 10);)
+                break;
+            case STORE_0X:
+                CHIP8_ACTIVE_LANES(
+                    for (unsigned i = 0; i <= instr.x; ++i)
+                        store(lane, I_[lane] + i, V_[i][lane]);
+                    if (Quirks::memoryIncrementsI)
+                        I_[lane] += instr.x + !Quirks::memoryIncrementsByX;)
+                break;
+            case FILLS_0X:
+                CHIP8_ACTIVE_LANES(
+                    for (unsigned i = 0; i <= instr.x; ++i)
+                        V_[i][lane] = memory_[lane][(I_[lane] + i) & 0xFFFF];
+                    if (Quirks::memoryIncrementsI)
+                        I_[lane] += instr.x + !Quirks::memoryIncrementsByX;)
+                break;
+            case STORE_FLAGS_0X:
+                CHIP8_ACTIVE_LANES(
+                    for (unsigned i = 0; i <= instr.x; ++i)
+                        flags_[lane][i] = V_[i][lane];)
+                break;
+            case FILLS_FLAGS_0X:
+                CHIP8_ACTIVE_LANES(
+                    for (unsigned i = 0; i <= instr.x; ++i)
+                        V_[i][lane] = flags_[lane][i];)
+                break;
+            default:
+                break;
+        };
+
+# undef CHIP8_BLEND
+# undef CHIP8_ACTIVE_LANES
+# undef CHIP8_LANES
+    }
+}
+
+#endif /* !WIDE_HH_ */